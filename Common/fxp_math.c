@@ -0,0 +1,137 @@
+#include "fxp_math.h"
+
+#define LN2_Q30 744261118LL          // ln 2
+#define INV_LN2_Q16 94548            // 1 / ln 2
+#define EXP_MAX_Q16 681391           // ln(32768): e^x no longer fits Q16.16 above this
+#define EXP_MIN_Q16 (-772243)        // ln(2^-17): e^x rounds to 0 below this
+
+// sin(i * pi / 512) in Q16 for i = 0..255; entry 256 (1.0) is implied
+static const uint16_t quarter_sine[256] = {
+        0,   402,   804,  1206,  1608,  2010,  2412,  2814,  3216,  3617,  4019,  4420,
+     4821,  5222,  5623,  6023,  6424,  6824,  7224,  7623,  8022,  8421,  8820,  9218,
+     9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391, 12785, 13180, 13573, 13966,
+    14359, 14751, 15143, 15534, 15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699, 22078, 22457, 22834, 23210,
+    23586, 23961, 24335, 24708, 25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538, 30893, 31248, 31600, 31952,
+    32303, 32652, 33000, 33347, 33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716, 39040, 39362, 39683, 40002,
+    40320, 40636, 40951, 41264, 41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056, 46341, 46624, 46906, 47186,
+    47464, 47741, 48015, 48288, 48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398, 52639, 52878, 53114, 53349,
+    53581, 53812, 54040, 54267, 54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+    56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607, 57798, 57986, 58172, 58356,
+    58538, 58718, 58896, 59071, 59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568, 61705, 61839, 61971, 62101,
+    62228, 62353, 62476, 62596, 62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+    63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197, 64277, 64354, 64429, 64501,
+    64571, 64639, 64704, 64766, 64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436, 65457, 65476, 65492, 65505,
+    65516, 65525, 65531, 65535,
+};
+
+// Taylor coefficients 1/n! in Q30, n = 0..8
+static const int32_t exp_coeff[9] = { 1073741824, 1073741824, 536870912, 178956971, 44739243, 8947849, 1491308, 213044, 26631 };
+
+// --- Internal Helper Functions ---
+
+// sin(x * pi/2 / 2^30) for x in [0, 2^30]
+static int32_t quarter(uint32_t x) {
+    uint32_t i = x >> 22;
+    if (i >= 256U) return FXP_ONE;
+    int32_t a = quarter_sine[i];
+    int32_t b = (i < 255U) ? quarter_sine[i + 1U] : FXP_ONE;
+    int32_t f = (int32_t)((x >> 6) & 0xFFFFU);
+    return a + (((b - a) * f + 0x8000) >> 16);
+}
+
+// --- Public Functions ---
+
+int32_t fxp_sin(uint32_t phase) {
+    uint32_t x = phase & (FXP_QUARTER_TURN - 1U);
+    if (phase & FXP_QUARTER_TURN) x = FXP_QUARTER_TURN - x; // Second and fourth quadrant mirror
+    int32_t s = quarter(x);
+    return (phase & FXP_HALF_TURN) ? -s : s;
+}
+
+int32_t fxp_cos(uint32_t phase) {
+    return fxp_sin(phase + FXP_QUARTER_TURN);
+}
+
+uint32_t fxp_phase_step(uint32_t freq_q16, uint32_t rate_hz) {
+    return (uint32_t)((((uint64_t)freq_q16 << 16) + (rate_hz >> 1)) / rate_hz);
+}
+
+int32_t fxp_exp(int32_t x) {
+    if (x > EXP_MAX_Q16) return INT32_MAX;
+    if (x < EXP_MIN_Q16) return 0;
+
+    // x = k * ln 2 + r, 0 <= r < ln 2 (r in Q30, so ln 2 is not rounded to Q16)
+    int32_t k = (int32_t)(((int64_t)x * INV_LN2_Q16) >> 32);
+    int64_t r30 = ((int64_t)x << 14) - k * LN2_Q30;
+    while (r30 < 0) { r30 += LN2_Q30; k--; }
+    while (r30 >= LN2_Q30) { r30 -= LN2_Q30; k++; }
+
+    // e^r in Q30 by Horner
+    int64_t p = exp_coeff[8];
+    for (int8_t n = 7; n >= 0; n--) p = exp_coeff[n] + ((p * r30) >> 30);
+
+    // 2^k * e^r back to Q16, rounded
+    int32_t shift = 14 - k;
+    if (shift <= 0) {
+        int64_t v = p << -shift;
+        return (v > INT32_MAX) ? INT32_MAX : (int32_t)v;
+    }
+    if (shift >= 62) return 0;
+    return (int32_t)((p + (1LL << (shift - 1))) >> shift);
+}
+
+uint32_t fxp_sqrt(uint32_t x) {
+    if (x == 0U) return 0U;
+
+    // d = x * 2^n in [2^30, 2^32), n even: [0.25, 1) in Q32
+    uint32_t n = (uint32_t)__builtin_clz(x) & ~1U;
+    uint32_t d = x << n;
+
+    // y ~ 1/sqrt(d) in Q30: 2.13 - 1.215 d is within 9 %, three steps reach 2^-24
+    uint64_t y = 2287070085U - (((uint64_t)1304596316U * d) >> 32);
+    for (uint8_t i = 0; i < 3; i++) {
+        uint64_t dy2 = (((y * y) >> 30) * d) >> 32;                        // d * y^2, Q30
+        y = (y * (3ULL * (1ULL << 30) - dy2)) >> 31;                       // y * (3 - d * y^2) / 2
+    }
+
+    // sqrt(x) in Q16 = sqrt(d) * 2^(8 - n/2), then the last LSB by exact integer compare
+    uint32_t shift = 8U + (n >> 1);
+    uint64_t r = (((d * y) >> 30) + (1ULL << (shift - 1U))) >> shift;
+    uint64_t t = (uint64_t)x << FXP_Q;
+    while (r * r + r < t) r++;                 // Round to nearest: r^2 - r < t <= r^2 + r
+    while (r > 0U && r * r - r >= t) r--;
+    return (uint32_t)r;
+}
+
+int32_t fxp_recip(int32_t x) {
+    if (x == 0) return INT32_MAX;
+    uint32_t m = (x < 0) ? (uint32_t)-(int64_t)x : (uint32_t)x;
+
+    // d = m * 2^n in [2^31, 2^32): [0.5, 1) in Q32
+    uint32_t n = (uint32_t)__builtin_clz(m);
+    uint32_t d = m << n;
+
+    // y ~ 1/d in Q30: 48/17 - 32/17 d is within 1/17 on [0.5, 1), three steps reach Q30
+    uint32_t y = 3031741621U - (uint32_t)(((uint64_t)2021161081U * d) >> 32);
+    for (uint8_t i = 0; i < 3; i++) {
+        uint32_t dy = (uint32_t)(((uint64_t)d * y) >> 32);                 // d * y, Q30
+        y = (uint32_t)(((uint64_t)y * ((1U << 31) - dy)) >> 30);         // y * (2 - d * y)
+    }
+
+    // 1/x in Q16 = y * 2^(n - 30)
+    uint64_t r;
+    if (n >= 30U) {
+        r = (uint64_t)y << (n - 30U);
+    } else {
+        r = ((uint64_t)y + (1ULL << (29U - n))) >> (30U - n);
+    }
+    if (r > INT32_MAX) r = INT32_MAX;
+    return (x < 0) ? -(int32_t)r : (int32_t)r;
+}
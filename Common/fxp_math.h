@@ -0,0 +1,75 @@
+#ifndef INC_FXP_MATH_H_
+#define INC_FXP_MATH_H_
+
+#include <stdint.h>
+
+// --- Fixed-Point Math ---
+// Integer-only replacements for sinf/cosf/expf/sqrtf and runtime divides, for targets without
+// an FPU (STM32L0) and for interrupt paths on the ones that have it. Values are Q16.16 in
+// int32_t, the format of pid_ctlr.h's fixed_t; angles are a full turn in uint32_t (2^32 = 2*pi),
+// the format of a phase accumulator. Add this directory to the include path of a project.
+//
+// Error bounds over the whole input range, measured against double libm by host/fxp_bench:
+//   fxp_sin/fxp_cos  <= 1.25 LSB (1.9e-5)
+//   fxp_exp          <= 0.5 LSB + 2^-23 relative; INT32_MAX above x = 10.397, 0 below -11.78
+//   fxp_sqrt         <= 0.5 LSB (correctly rounded)
+//   fxp_recip        <= 0.5 LSB + 2^-25 relative; +-INT32_MAX for |x| <= 2^-15 and x = 0
+#define FXP_Q 16
+#define FXP_ONE (1L << FXP_Q)
+#define FXP_HALF_TURN 0x80000000UL
+#define FXP_QUARTER_TURN 0x40000000UL
+#define FXP_TWO_PI 411775L               // 2 * pi in Q16
+
+// Compile-time float to Q16 (constants only: a runtime argument pulls in soft-float)
+#define FXP_FROM_FLOAT(x) ((int32_t)((x) * (float)FXP_ONE + ((x) >= 0 ? 0.5f : -0.5f)))
+
+// num / den as a Q16 multiplier, rounded up: (p * FXP_RATIO_Q16(num, den)) >> 16 is exactly the
+// truncated p * num / den for every 0 <= p < 2^16 / den, with no divide at run time.
+#define FXP_RATIO_Q16(num, den) ((uint32_t)((((uint64_t)(num) << 16) + (den) - 1U) / (den)))
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Q16 multiply with 64-bit intermediate.
+ */
+static inline int32_t fxp_mul(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> FXP_Q);
+}
+
+/**
+ * @brief Sine of a phase (2^32 = one turn), Q16.
+ * @note 256-segment quarter-wave table with linear interpolation; one multiply.
+ */
+int32_t fxp_sin(uint32_t phase);
+
+/**
+ * @brief Cosine of a phase (2^32 = one turn), Q16.
+ */
+int32_t fxp_cos(uint32_t phase);
+
+/**
+ * @brief Phase step per sample for a frequency, rounded; call once, not per sample.
+ * @param freq_q16 Frequency (Hz, Q16).
+ * @param rate_hz Sample rate (Hz).
+ */
+uint32_t fxp_phase_step(uint32_t freq_q16, uint32_t rate_hz);
+
+/**
+ * @brief e^x, Q16 in and out.
+ * @note Range reduction to 2^k * e^r, r in [0, ln 2), then a degree-8 polynomial.
+ */
+int32_t fxp_exp(int32_t x);
+
+/**
+ * @brief Square root, Q16 in and out (unsigned).
+ * @note Normalizes to [0.25, 1), 3 Newton steps on 1/sqrt, then an exact rounding check.
+ */
+uint32_t fxp_sqrt(uint32_t x);
+
+/**
+ * @brief 1/x, Q16 in and out; the sign of x is kept.
+ * @note Normalizes to [0.5, 1), then 3 Newton steps from a linear first guess.
+ */
+int32_t fxp_recip(int32_t x);
+
+#endif /* INC_FXP_MATH_H_ */
@@ -0,0 +1,109 @@
+/*
+ * fxp_bench: accuracy and throughput of fxp_math against libm.
+ *
+ * Build (from Common/):
+ *   cc -O2 -std=gnu99 -I. host/fxp_bench.c fxp_math.c -lm -o fxp_bench
+ *
+ * Usage:
+ *   fxp_bench
+ *
+ * Accuracy: the largest error over the whole input range (every phase step of 2^8, every
+ * Q16 input of sqrt/recip in range, every 16th of exp) against double libm, in Q16 LSB and
+ * relative. Throughput: ns per call on this host against the float libm call the firmware
+ * used before. The host has an FPU, so the ratio is only indicative of a Cortex-M4F; on an
+ * FPU-less Cortex-M0+ every float call in the right column is a soft-float library call.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "fxp_math.h"
+
+#define BENCH_CALLS 20000000U
+
+static volatile int32_t sink_i;
+static volatile float sink_f;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct {
+    double lsb;   // Largest absolute error (Q16 LSB)
+    double rel;   // Largest relative error where |exact| >= 256 (rounding to Q16 is below 2^-24 there)
+} ErrStat;
+
+static void track(ErrStat *e, double got_q16, double exact) {
+    double err = fabs(got_q16 / FXP_ONE - exact);
+    if (err * FXP_ONE > e->lsb) e->lsb = err * FXP_ONE;
+    if (fabs(exact) >= 256.0 && err / fabs(exact) > e->rel) e->rel = err / fabs(exact);
+}
+
+static void report(const char *name, const ErrStat *e, double ns_fxp, double ns_libm, const char *libm) {
+    if (e->rel > 0.0) printf("%-10s %10.3f %12.3g %10.2f %10.2f  %s\n", name, e->lsb, e->rel, ns_fxp, ns_libm, libm);
+    else printf("%-10s %10.3f %12s %10.2f %10.2f  %s\n", name, e->lsb, "-", ns_fxp, ns_libm, libm);
+}
+
+int main(void) {
+    ErrStat e;
+    double t0, t_fxp, t_libm;
+    printf("%-10s %10s %12s %10s %10s  %s\n", "function", "max LSB", "max rel", "ns fxp", "ns libm", "libm call");
+
+    // --- sin / cos ---
+    e = (ErrStat){ 0 };
+    for (uint64_t p = 0; p < (1ULL << 32); p += 1U << 8) {
+        double a = (double)p / 4294967296.0 * 2.0 * M_PI;
+        track(&e, fxp_sin((uint32_t)p), sin(a));
+        track(&e, fxp_cos((uint32_t)p), cos(a));
+    }
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_i = fxp_sin(i * 2654435761U);
+    t_fxp = (now_ns() - t0) / BENCH_CALLS;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_f = sinf((float)(i * 2654435761U) * 1.4629181e-9f);
+    t_libm = (now_ns() - t0) / BENCH_CALLS;
+    report("sin/cos", &e, t_fxp, t_libm, "sinf");
+
+    // --- exp ---
+    e = (ErrStat){ 0 };
+    for (int32_t x = -800000; x <= 681391; x += 16) {
+        double exact = exp((double)x / FXP_ONE);
+        if (exact * FXP_ONE < 2147483647.0) track(&e, fxp_exp(x), exact);
+    }
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_i = fxp_exp((int32_t)(i & 0xFFFFFU) - 500000);
+    t_fxp = (now_ns() - t0) / BENCH_CALLS;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_f = expf((float)((int32_t)(i & 0xFFFFFU) - 500000) * 1.5258789e-5f);
+    t_libm = (now_ns() - t0) / BENCH_CALLS;
+    report("exp", &e, t_fxp, t_libm, "expf");
+
+    // --- sqrt ---
+    e = (ErrStat){ 0 };
+    for (uint64_t x = 0; x <= INT32_MAX; x += 7) track(&e, fxp_sqrt((uint32_t)x), sqrt((double)x / FXP_ONE));
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_i = (int32_t)fxp_sqrt(i * 97U);
+    t_fxp = (now_ns() - t0) / BENCH_CALLS;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_f = sqrtf((float)(i * 97U) * 1.5258789e-5f);
+    t_libm = (now_ns() - t0) / BENCH_CALLS;
+    report("sqrt", &e, t_fxp, t_libm, "sqrtf");
+
+    // --- reciprocal ---
+    e = (ErrStat){ 0 };
+    for (int64_t x = 3; x <= INT32_MAX; x += 5) {
+        track(&e, fxp_recip((int32_t)x), FXP_ONE / (double)x);
+        track(&e, fxp_recip((int32_t)-x), -FXP_ONE / (double)x);
+    }
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_i = fxp_recip((int32_t)(i | 4U));
+    t_fxp = (now_ns() - t0) / BENCH_CALLS;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) sink_f = 1.0f / ((float)(i | 4U) * 1.5258789e-5f);
+    t_libm = (now_ns() - t0) / BENCH_CALLS;
+    report("recip", &e, t_fxp, t_libm, "1.0f / x");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "rt_exec.h"
+
+// --- Executive State ---
+static ExecTask *table = 0;
+static uint8_t table_n = 0;
+static ExecClockFn clock_fn = 0;
+static uint32_t clock_per_us = 1;
+static volatile uint32_t tick = 0;
+
+// --- Public Functions ---
+
+void exec_init(ExecTask *tasks, uint8_t count, ExecClockFn clock, uint32_t counts_per_us) {
+    table = tasks;
+    table_n = count;
+    clock_fn = clock;
+    clock_per_us = (counts_per_us > 0U) ? counts_per_us : 1U;
+    tick = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        ExecTask *t = &tasks[i];
+        if (t->period == 0U) t->period = 1U;
+        t->release = t->offset;
+        t->budget_counts = t->budget_us * clock_per_us;
+        t->runs = 0;
+        t->max_counts = 0;
+        t->max_lateness = 0;
+        t->overruns = 0;
+        t->misses = 0;
+        t->overrun = false;
+    }
+}
+
+void exec_tick(void) {
+    tick++;
+}
+
+uint32_t exec_ticks(void) {
+    return tick;
+}
+
+bool exec_run(void) {
+    uint32_t now = tick;
+
+    for (uint8_t i = 0; i < table_n; i++) {
+        ExecTask *t = &table[i];
+        uint32_t late = now - t->release;
+        if ((int32_t)late < 0) continue; // Not released yet
+
+        // Releases that passed while this one waited are lost, not queued
+        if (late >= t->period) {
+            uint32_t skipped = late / t->period;
+            t->misses += skipped;
+            t->release += skipped * t->period;
+            t->overrun = true;
+        }
+        if (late > t->max_lateness) t->max_lateness = late;
+
+        uint32_t start = clock_fn();
+        t->fn(t->ctx);
+        uint32_t used = clock_fn() - start;
+
+        t->runs++;
+        if (used > t->max_counts) t->max_counts = used;
+        if (used > t->budget_counts) {
+            t->overruns++;
+            t->overrun = true;
+        }
+        t->release += t->period;
+        return true;
+    }
+    return false;
+}
+
+uint32_t exec_task_max_us(const ExecTask *task) {
+    return (task->max_counts + clock_per_us - 1U) / clock_per_us;
+}
+
+bool exec_overrun(void) {
+    for (uint8_t i = 0; i < table_n; i++) {
+        if (table[i].overrun) return true;
+    }
+    return false;
+}
+
+void exec_clear_flags(void) {
+    for (uint8_t i = 0; i < table_n; i++) table[i].overrun = false;
+}
+
+bool exec_schedulable(const ExecTask *tasks, uint8_t count, uint32_t tick_us, uint32_t *response_us) {
+    bool ok = true;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t period_us = (uint64_t)tasks[i].period * tick_us;
+        uint64_t blocking = tasks[i].budget_us;
+        for (uint8_t k = i + 1U; k < count; k++) {
+            if (tasks[k].budget_us > blocking) blocking = tasks[k].budget_us;
+        }
+
+        // Start time of the job: fixed point of w = B + sum over hp(i) of ceil((w + 1) / T) * C
+        uint64_t w = blocking, prev = 0;
+        while (w != prev && w <= period_us) {
+            prev = w;
+            w = blocking;
+            for (uint8_t j = 0; j < i; j++) {
+                uint64_t tj = (uint64_t)tasks[j].period * tick_us;
+                w += ((prev + 1U + tj - 1U) / tj) * tasks[j].budget_us;
+            }
+        }
+        uint64_t r = w + tasks[i].budget_us;
+        if (r > period_us) ok = false;
+        if (response_us) response_us[i] = (r > UINT32_MAX) ? UINT32_MAX : (uint32_t)r;
+    }
+    return ok;
+}
@@ -0,0 +1,86 @@
+#ifndef INC_RT_EXEC_H_
+#define INC_RT_EXEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Run-to-Completion Executive ---
+// Periodic tasks with static priorities (table order, index 0 first) on one timer tick.
+// exec_tick() only counts ticks, from the timer interrupt; exec_run() in the main loop starts
+// the highest-priority task whose release time has come and runs it to completion. Tasks never
+// preempt each other, so data shared only between tasks needs no locking, and the order of
+// execution is a pure function of the tick count and the task execution times.
+// The same code runs on the host with a simulated tick and clock (host/exec_sim.c).
+
+typedef void (*ExecTaskFn)(void *ctx);
+typedef uint32_t (*ExecClockFn)(void); // Free-running counter, wraps at 2^32
+
+typedef struct {
+    // Set by the application
+    const char *name;
+    ExecTaskFn fn;
+    void *ctx;
+    uint32_t period;        // Ticks between releases (deadline = next release)
+    uint32_t offset;        // Tick of the first release, to spread tasks with equal periods
+    uint32_t budget_us;     // Worst-case execution time the schedule was designed for
+
+    // Maintained by the executive
+    uint32_t release;       // Tick of the pending (or next) release
+    uint32_t budget_counts;
+    uint32_t runs;
+    uint32_t max_counts;    // Longest measured execution (clock counts)
+    uint32_t max_lateness;  // Longest start delay after release (ticks)
+    uint32_t overruns;      // Runs longer than budget_us
+    uint32_t misses;        // Releases skipped because the previous one had not started yet
+    bool overrun;           // Sticky: set with overruns/misses, cleared by exec_clear_flags()
+} ExecTask;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Binds a task table (priority order) and the execution-time clock.
+ * @param counts_per_us Clock counts per microsecond (e.g. SystemCoreClock / 1e6 for DWT->CYCCNT).
+ */
+void exec_init(ExecTask *tasks, uint8_t count, ExecClockFn clock, uint32_t counts_per_us);
+
+/**
+ * @brief Advances the tick; call from the timer interrupt (or the host simulation).
+ */
+void exec_tick(void);
+
+/**
+ * @brief Current tick count.
+ */
+uint32_t exec_ticks(void);
+
+/**
+ * @brief Runs the highest-priority released task to completion.
+ * @return false if no task was due (the caller may sleep until the next interrupt).
+ */
+bool exec_run(void);
+
+/**
+ * @brief Longest measured execution time of a task (us).
+ */
+uint32_t exec_task_max_us(const ExecTask *task);
+
+/**
+ * @brief True if any task has overrun its budget or missed a release since the last clear.
+ */
+bool exec_overrun(void);
+
+/**
+ * @brief Clears the sticky overrun flags (counters are kept).
+ */
+void exec_clear_flags(void);
+
+/**
+ * @brief Worst-case response time of every task from the budgets (us).
+ * @note Sufficient test for non-preemptive fixed priorities (Davis et al. 2007): blocking by
+ *       the longest lower-priority task, interference from all higher-priority releases.
+ * @param response_us Per-task response times (count entries), may be NULL.
+ * @return true if every response time is within the task's period.
+ */
+bool exec_schedulable(const ExecTask *tasks, uint8_t count, uint32_t tick_us, uint32_t *response_us);
+
+#endif /* INC_RT_EXEC_H_ */
@@ -1,16 +1,26 @@
 #include "stm32l0xx_hal.h"
 #include "pid_ctlr.h"
+#include "rt_exec.h"  // Run-to-completion task executive (Common/)
+
+#define ENCODER_COUNTS_PER_REV 1024
 
 TIM_HandleTypeDef htim2;  // Encoder timer
 TIM_HandleTypeDef htim3;  // PWM timer
 TIM_HandleTypeDef htim21; // Sample timer
 
 PIDController pid;
-volatile uint8_t pid_flag = 0;
 
 void SystemClock_Config(void);
 void GPIO_Init(void);
 void Timer_Init(void);
+static void pid_task(void *ctx);
+static uint32_t exec_clock(void);
+
+// Tasks in priority order, one tick per TIM21 update (PID_SAMPLE_RATE_HZ); check the budgets
+// with Common/host/exec_sim before changing them
+static ExecTask tasks[] = {
+    { .name = "pid", .fn = pid_task, .period = 1, .budget_us = 40 },
+};
 
 int main(void) {
     HAL_Init();
@@ -21,33 +31,50 @@ int main(void) {
     PID_Init(&pid);
     pid.setpoint = FLOAT_TO_FIXED(1.0f); // 1 revolution setpoint
     
+    exec_init(tasks, sizeof(tasks) / sizeof(tasks[0]), exec_clock, SystemCoreClock / 1000000U);
     while (1) {
-        if (pid_flag) {
-            pid_flag = 0;
-            
-            // Read encoder (converts to Q15.16)
-            int32_t count = TIM2->CNT;
-            fixed_t position = FLOAT_TO_FIXED(count / 1024.0f);
-            
-            // Update PID
-            fixed_t output = PID_Update(&pid, position);
-            
-            // Apply output to PWM (convert back to integer)
-            int32_t pwm = output >> FIXED_BITS;
-            if (pwm > 0) {
-                TIM3->CCR1 = pwm;
-                TIM3->CCR2 = 0;
-            } else {
-                TIM3->CCR1 = 0;
-                TIM3->CCR2 = -pwm;
-            }
+        if (!exec_run()) {
+            __WFI(); // Nothing due: sleep until the next tick
         }
     }
 }
 
+static void pid_task(void *ctx) {
+    (void)ctx;
+
+    // Read encoder (converts to Q15.16: revolutions, no float on the FPU-less L0)
+    int32_t count = TIM2->CNT;
+    fixed_t position = count * (FIXED_ONE / ENCODER_COUNTS_PER_REV);
+    
+    // Update PID
+    fixed_t output = PID_Update(&pid, position);
+    
+    // Apply output to PWM (convert back to integer)
+    int32_t pwm = output >> FIXED_BITS;
+    if (pwm > 0) {
+        TIM3->CCR1 = pwm;
+        TIM3->CCR2 = 0;
+    } else {
+        TIM3->CCR1 = 0;
+        TIM3->CCR2 = -pwm;
+    }
+}
+
+// Execution-time clock (core cycles, wraps at 2^32)
+static uint32_t exec_clock(void) {
+    // The Cortex-M0+ has no DWT cycle counter: extend the SysTick down-counter with the HAL
+    // millisecond count, re-reading if the SysTick interrupt ran in between
+    uint32_t ms, val;
+    do {
+        ms = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+    return ms * (SysTick->LOAD + 1U) + (SysTick->LOAD - val);
+}
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
     if (htim->Instance == TIM21) {
-        pid_flag = 1;
+        exec_tick();
     }
 }
 
@@ -1,4 +1,5 @@
 #include "pid_ctlr.h"
+#include "fxp_math.h"  // Integer exp (Common/), Q16.16 like fixed_t
 
 // Helper function to constrain value between limits
 static fixed_t constrain(fixed_t value, fixed_t min, fixed_t max) {
@@ -14,9 +15,9 @@ void PID_Init(PIDController *pid) {
     pid->kd = FLOAT_TO_FIXED(0.01f);
     pid->ka = FLOAT_TO_FIXED(0.1f);      // Anti-windup gain
     
-    // LPF coefficient for 10 rad/sec with 100us sample time
-    // coeff = 2π * 10 * 0.0001 = 0.00628
-    pid->lpf_coeff = FLOAT_TO_FIXED(0.00628f);
+    // LPF coefficient for 10 Hz with 100us sample time
+    // coeff = 1 - exp(-2π * 10 * 0.0001) = 0.00626
+    PID_SetDerivativeCutoff(pid, FLOAT_TO_FIXED(PID_DERIV_CUTOFF_HZ), PID_SAMPLE_RATE_HZ);
     
     // Set limits
     pid->output_limit_max = FLOAT_TO_FIXED(1000.0f);  // Adjust based on your PWM range
@@ -29,6 +30,15 @@ void PID_Init(PIDController *pid) {
     pid->prev_deriv = 0;
 }
 
+// Derivative LPF coefficient, matched-pole discretization of the first-order filter:
+// coeff = 1 - exp(-2π * fc / fs), integer only so it can be retuned at run time.
+// wt is rounded to Q16 (and exp to its last LSB), so coeff is within ~1 LSB, not exact
+void PID_SetDerivativeCutoff(PIDController *pid, fixed_t cutoff_hz, uint32_t sample_rate_hz) {
+    uint32_t turns = fxp_phase_step((uint32_t)cutoff_hz, sample_rate_hz); // fc / fs, 2^32 = 1
+    fixed_t wt = (fixed_t)(((uint64_t)turns * FXP_TWO_PI + (1ULL << 31)) >> 32);
+    pid->lpf_coeff = FIXED_ONE - fxp_exp(-wt);
+}
+
 fixed_t PID_Update(PIDController *pid, fixed_t measurement) {
     // Calculate error
     fixed_t error = pid->setpoint - measurement;
@@ -38,7 +48,9 @@ fixed_t PID_Update(PIDController *pid, fixed_t measurement) {
     
     // Integral term with deadband and anti-windup
     fixed_t i_term;
-    if (FIXED_MULT(error, error) > FIXED_MULT(pid->integral_deadband, pid->integral_deadband)) {
+    // |error| against the deadband: what error^2 > deadband^2 meant, without its Q16
+    // truncation and the two 64-bit multiplies (library calls on the Cortex-M0+)
+    if (error > pid->integral_deadband || error < -pid->integral_deadband) {
         // Only integrate if error exceeds deadband
         pid->integral += FIXED_MULT(pid->ki, error);
     }
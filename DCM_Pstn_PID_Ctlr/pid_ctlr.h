@@ -11,6 +11,10 @@ typedef int32_t fixed_t;
 #define FIXED_TO_FLOAT(x) ((float)(x) / FIXED_ONE)
 #define FIXED_MULT(x, y) (((int64_t)(x) * (y)) >> FIXED_BITS)
 
+// Sample rate and derivative filter cutoff used by PID_Init()
+#define PID_SAMPLE_RATE_HZ 10000     // 100us sample time
+#define PID_DERIV_CUTOFF_HZ 10.0f
+
 // PID structure
 typedef struct {
     // Gains
@@ -33,6 +37,7 @@ typedef struct {
 } PIDController;
 
 void PID_Init(PIDController *pid);
+void PID_SetDerivativeCutoff(PIDController *pid, fixed_t cutoff_hz, uint32_t sample_rate_hz);
 fixed_t PID_Update(PIDController *pid, fixed_t measurement);
 
 #endif
@@ -1,5 +1,10 @@
+#include <stdio.h>
 #include "servo_control.h"
 #include "servo_command.h"
+#include "rc_traj.h"
+#include "rt_exec.h" // Run-to-completion task executive (Common/)
+
+#define EXEC_TICK_US 1000U // TIMx update period
 
 // Hardware Abstraction Layer prototypes
 // These functions provide hardware-specific implementations for PWM, UART, and timer functionality
@@ -10,9 +15,24 @@ int uart_receive_byte(void); // Receive a byte from UART (non-blocking)
 void uart_send_string(const char* str); // Send a string over UART
 void init_timer_interrupt(void); // Initialize timer interrupt for periodic updates
 uint32_t HAL_GetTick(void); // Get the current system tick (time in ms)
+void servo_enter_critical(void); // Mask the servo timer interrupt
+void servo_exit_critical(void); // Unmask the servo timer interrupt
 
 // Global servo state
 ServoState servo;
+ServoTrajectory servo_traj; // DMA trajectory streamed to the PWM compare register
+
+static void servo_task(void* ctx);
+static void command_task(void* ctx);
+static void telemetry_task(void* ctx);
+
+// Tasks in priority order, one tick per TIMx interrupt
+// Check the budgets with Common/host/exec_sim before changing them
+static ExecTask tasks[] = {
+    { .name = "servo",     .fn = servo_task,     .period = 1,    .budget_us = 50 },
+    { .name = "command",   .fn = command_task,   .period = 1,    .budget_us = 200 },
+    { .name = "telemetry", .fn = telemetry_task, .period = 1000, .budget_us = 400 },
+};
 
 int main() {
     // Initialize hardware peripherals
@@ -27,27 +47,61 @@ int main() {
     printf("Servo Controller Initialized.\n");
     uart_send_string("Servo Controller Ready.\n");
 
-    // Variables for periodic monitoring
-    uint32_t last_monitor_time = 0;
-    uint32_t monitor_interval_ms = 1000; // Monitor every 1000ms (1 second)
+    exec_init(tasks, sizeof(tasks) / sizeof(tasks[0]), latency_now, 1); // 1 MHz, LATENCY_TICK_US 1
+    if (!exec_schedulable(tasks, sizeof(tasks) / sizeof(tasks[0]), EXEC_TICK_US, NULL)) {
+        printf("Task budgets exceed the schedule.\n");
+    }
 
     while (1) {
-        // Process incoming UART commands
-        process_uart_command(&servo);
-
-        // Periodically send monitoring data
-        uint32_t current_time = HAL_GetTick();
-        if (current_time - last_monitor_time >= monitor_interval_ms) {
-            send_monitoring_data(&servo);
-            last_monitor_time = current_time;
+        exec_run();
+    }
+}
+
+// --- Tasks ---
+
+static void servo_task(void* ctx) {
+    (void)ctx;
+    if (!servo_traj_active(&servo_traj)) { // The DMA owns the compare register during a trajectory
+        servo_update(&servo);
+    }
+}
+
+static void command_task(void* ctx) {
+    (void)ctx;
+    process_uart_command(&servo);
+}
+
+static void telemetry_task(void* ctx) {
+    (void)ctx;
+    send_monitoring_data(&servo);
+
+    if (exec_overrun()) {
+        char buffer[80];
+        for (uint8_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+            snprintf(buffer, sizeof(buffer), "EXEC %s max=%luus overruns=%lu misses=%lu\n", tasks[i].name,
+                     (unsigned long)exec_task_max_us(&tasks[i]), (unsigned long)tasks[i].overruns,
+                     (unsigned long)tasks[i].misses);
+            uart_send_string(buffer);
         }
+        exec_clear_flags();
     }
 }
 
 // Timer Interrupt Handler
-// This function is called periodically by the timer interrupt to update the servo state
+// Only releases tasks; servo_update() runs in the servo task
 void TIMx_IRQHandler(void) {
-    servo_update(&servo);
+    exec_tick();
+}
+
+// DMA Interrupt Handlers
+// Called for the DMA channel serving the PWM timer update request
+// Each handler refills the half of the trajectory buffer that has just been played
+void DMAx_HT_IRQHandler(void) {
+    servo_traj_dma_half_complete(&servo_traj, &servo);
+}
+
+void DMAx_TC_IRQHandler(void) {
+    servo_traj_dma_complete(&servo_traj, &servo);
 }
 
 // HAL Implementations (Placeholders for STM32 HAL)
@@ -81,3 +135,27 @@ void init_timer_interrupt() {
     printf("HAL: Timer Interrupt Initialized (STM32 Placeholder).\n");
 }
 
+void pwm_dma_start(const uint16_t* buffer, uint16_t length) {
+    // Placeholder implementation: HAL_DMA_Start_IT(&hdma_timx_up, (uint32_t)buffer, (uint32_t)&TIMx->CCR1, length)
+    // in circular mode, then __HAL_TIM_ENABLE_DMA(&htimx, TIM_DMA_UPDATE)
+    printf("HAL: PWM DMA started (%d samples).\n", length);
+}
+
+uint32_t latency_now() {
+    // Placeholder implementation: free-running 1 MHz timer counter (e.g. TIM2->CNT with PSC = SYSCLK/1MHz - 1)
+    return HAL_GetTick() * 1000;
+}
+
+uint16_t pwm_dma_stop() {
+    // Placeholder implementation: __HAL_TIM_DISABLE_DMA(&htimx, TIM_DMA_UPDATE), HAL_DMA_Abort(&hdma_timx_up)
+    return 0; // Remaining transfer count (__HAL_DMA_GET_COUNTER)
+}
+
+void servo_enter_critical() {
+    // Placeholder implementation: __disable_irq() or HAL_NVIC_DisableIRQ(TIMx_IRQn)
+}
+
+void servo_exit_critical() {
+    // Placeholder implementation: __enable_irq() or HAL_NVIC_EnableIRQ(TIMx_IRQn)
+}
+
@@ -1,43 +1,213 @@
 #include "servo_command.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-/* Process UART Commands
- * Reads and processes commands from UART with the following format:
+static const char* const result_text[] = {
+    "OK\n",         // CMD_OK
+    "ERR SYNTAX\n", // CMD_ERR_SYNTAX
+    "ERR RANGE\n",  // CMD_ERR_RANGE
+    "ERR FULL\n",   // CMD_ERR_FULL
+    "ERR BUSY\n"    // CMD_ERR_BUSY
+};
+
+/* Skip leading spaces */
+static char* skip_spaces(char* str) {
+    while (*str == ' ' || *str == '\t') str++;
+    return str;
+}
+
+/* Parse an unsigned decimal number
+ * Returns false if no digits are found or the value exceeds max
+ * On success *end points to the first character after the number
+ */
+static bool parse_uint(char* str, uint32_t max, uint32_t* value, char** end) {
+    str = skip_spaces(str);
+    if (*str < '0' || *str > '9') return false;
+    unsigned long v = strtoul(str, end, 10);
+    *end = skip_spaces(*end);
+    if (v > max) {
+        *value = max + 1; // Caller reports this as a range error
+        return true;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+/* Parse a comma separated position list "a,b,c,..."
+ * All values are parsed before anything is applied so the list is handled as a whole
+ */
+static CommandResult parse_position_list(char* args, uint16_t* positions, uint8_t* count) {
+    bool out_of_range = false;
+
+    *count = 0;
+    for (;;) {
+        uint32_t value;
+        if (*count >= CMD_LIST_MAX) return CMD_ERR_FULL;
+        if (!parse_uint(args, 0xFFFF, &value, &args)) return CMD_ERR_SYNTAX;
+        if (value > SERVO_MAX_POS) out_of_range = true;
+        positions[(*count)++] = (uint16_t)value;
+        if (*args == '\0') break;
+        if (*args != ',') return CMD_ERR_SYNTAX;
+        args++;
+    }
+    return out_of_range ? CMD_ERR_RANGE : CMD_OK;
+}
+
+/* "POS a,b,c,..." - queue positions atomically */
+static CommandResult command_pos(ServoState* servo, char* args) {
+    uint16_t positions[CMD_LIST_MAX];
+    uint8_t count;
+    CommandResult result = parse_position_list(args, positions, &count);
+    if (result != CMD_OK) return result;
+    latency_command_parsed();
+
+    return servo_set_positions(servo, positions, count) ? CMD_OK : CMD_ERR_FULL;
+}
+
+/* "TRJ a,b,c,..." - stream a precomputed path by DMA, "TRJ STOP" aborts it */
+static CommandResult command_traj(ServoState* servo, char* args) {
+    uint16_t positions[CMD_LIST_MAX];
+    uint8_t count;
+
+    if (strcmp(args, "STOP") == 0) {
+        servo_traj_abort(&servo_traj, servo);
+        return CMD_OK;
+    }
+    if (servo_traj_active(&servo_traj) || !servo->is_on) return CMD_ERR_BUSY;
+
+    CommandResult result = parse_position_list(args, positions, &count);
+    if (result != CMD_OK) return result;
+
+    return servo_traj_start(&servo_traj, servo, positions, count) ? CMD_OK : CMD_ERR_BUSY;
+}
+
+/* Answer "GET xxx" queries */
+static CommandResult command_get(const ServoState* servo, const char* what) {
+    char buffer[64];
+    if (strcmp(what, "POS") == 0) {
+        snprintf(buffer, sizeof(buffer), "POS=%d\n", servo->current_position_raw);
+    } else if (strcmp(what, "TGT") == 0) {
+        snprintf(buffer, sizeof(buffer), "TGT=%d\n", servo->target_position_raw);
+    } else if (strcmp(what, "SPD") == 0) {
+        snprintf(buffer, sizeof(buffer), "SPD=%d\n", servo->moving_speed);
+    } else if (strcmp(what, "BUF") == 0) {
+        snprintf(buffer, sizeof(buffer), "BUF=%d/%d\n", servo->pos_buffer.count, POSITION_BUFFER_SIZE);
+    } else if (strcmp(what, "STATE") == 0) {
+        snprintf(buffer, sizeof(buffer), "STATE=%s\n", servo->is_on ? "ON" : "OFF");
+    } else if (strcmp(what, "LAT") == 0) {
+        latency_report(); // Multi-line answer, one line per stage
+        return CMD_OK;
+    } else if (strcmp(what, "TRJ") == 0) {
+        snprintf(buffer, sizeof(buffer), "TRJ=%s\n", servo_traj_active(&servo_traj) ? "RUN" : "IDLE");
+    } else {
+        return CMD_ERR_SYNTAX;
+    }
+    uart_send_string(buffer);
+    return CMD_OK;
+}
+
+/* Execute a single command
+ * Supported commands:
  * "ON" - Turn servo on
  * "OFF" - Turn servo off
  * "POS xxx" - Set position to xxx degrees
+ * "POS a,b,c,..." - Queue a list of positions atomically (all or nothing)
  * "SPD xxx" - Set speed to xxx units
+ * "TRJ a,b,c,..." - Stream a precomputed path by DMA ("TRJ STOP" aborts)
+ * "GET POS|TGT|SPD|BUF|STATE|TRJ" - Query a value
+ * "GET LAT" - Command-to-pulse latency statistics, "LAT RESET" clears them
+ * Sends one response line ("OK", "ERR ..." or the queried value)
+ */
+CommandResult execute_command(ServoState* servo, char* command) {
+    CommandResult result = CMD_ERR_SYNTAX;
+    uint32_t value;
+    char* end;
+
+    // Trim trailing spaces
+    size_t len = strlen(command);
+    while (len > 0 && (command[len - 1] == ' ' || command[len - 1] == '\t')) command[--len] = '\0';
+
+    if (strcmp(command, "ON") == 0) {
+        servo_set_state(servo, true); // Turn servo on
+        result = CMD_OK;
+    }
+    else if (strcmp(command, "OFF") == 0) {
+        servo_traj_abort(&servo_traj, servo); // Release the PWM output if a trajectory is running
+        servo_set_state(servo, false); // Turn servo off
+        result = CMD_OK;
+    }
+    else if (strncmp(command, "POS ", 4) == 0) {
+        result = command_pos(servo, &command[4]);
+    }
+    else if (strncmp(command, "SPD ", 4) == 0) {
+        if (parse_uint(&command[4], 0xFF, &value, &end) && *end == '\0') {
+            result = (value > 0 && value <= 0xFF) ? CMD_OK : CMD_ERR_RANGE;
+            if (result == CMD_OK) servo_set_speed(servo, (uint8_t)value); // Set servo speed
+        }
+    }
+    else if (strncmp(command, "TRJ ", 4) == 0) {
+        result = command_traj(servo, skip_spaces(&command[4]));
+    }
+    else if (strcmp(command, "LAT RESET") == 0) {
+        latency_reset();
+        result = CMD_OK;
+    }
+    else if (strncmp(command, "GET ", 4) == 0) {
+        // Value queries answer with the value itself, only errors use the generic text
+        result = command_get(servo, skip_spaces(&command[4]));
+        if (result == CMD_OK) return result;
+    }
+
+    uart_send_string(result_text[result]);
+    return result;
+}
+
+/* Execute every ';' separated command of a line in order
+ * A failing command does not stop the following ones; each gets its own response
+ */
+static void execute_line(ServoState* servo, char* line) {
+    while (line != NULL) {
+        char* next = strchr(line, CMD_SEPARATOR);
+        if (next != NULL) *next++ = '\0';
+        line = skip_spaces(line);
+        if (*line != '\0') {
+            execute_command(servo, line);
+        }
+        line = next;
+    }
+}
+
+/* Process UART Commands
+ * Reads bytes from UART and executes each complete line.
+ * The line buffer is kept between calls so a line may arrive over several calls.
+ * Lines longer than CMD_LINE_MAX are discarded with an "ERR SYNTAX" response.
  */
 void process_uart_command(ServoState* servo) {
-    char command[64]; // Buffer to store incoming command
-    int index = 0;    // Current index in the command buffer
-    int byte;         // Byte received from UART
+    static char command[CMD_LINE_MAX]; // Buffer to store incoming command line
+    static int index = 0;              // Current index in the command buffer
+    static bool overflow = false;      // Current line did not fit into the buffer
+    int byte;                          // Byte received from UART
 
-    // Read bytes until newline or buffer full
+    // Read bytes until no more data is pending
     while ((byte = uart_receive_byte()) != -1) {
         if (byte == '\n') {
+            latency_command_received(); // Start of the command-to-pulse measurement
             command[index] = '\0'; // Null-terminate the command string
-            
-            // Process complete command
-            if (strcmp(command, "ON") == 0) {
-                servo_set_state(servo, true); // Turn servo on
-            } 
-            else if (strcmp(command, "OFF") == 0) {
-                servo_set_state(servo, false); // Turn servo off
-            }
-            else if (strncmp(command, "POS", 3) == 0) {
-                // Extract position value after "POS "
-                uint16_t position = atoi(&command[4]);
-                servo_set_position(servo, position); // Set servo position
-            }
-            else if (strncmp(command, "SPD", 3) == 0) {
-                // Extract speed value after "SPD "
-                uint8_t speed = atoi(&command[4]);
-                servo_set_speed(servo, speed); // Set servo speed
+            if (overflow) {
+                uart_send_string(result_text[CMD_ERR_SYNTAX]);
+            } else {
+                execute_line(servo, command);
             }
             index = 0; // Reset buffer index for next command
+            overflow = false;
+        } else if (byte == '\r') {
+            // Ignore CR of CRLF line endings
         } else {
-            if (index < 63) { // Prevent buffer overflow
+            if (index < CMD_LINE_MAX - 1) { // Prevent buffer overflow
                 command[index++] = (char)byte;
+            } else {
+                overflow = true;
             }
         }
     }
@@ -2,28 +2,60 @@
 #define SERVO_COMMAND_H
 
 #include "servo_control.h"
+#include "rc_traj.h"
+
+// UART hooks implemented next to the other HAL placeholders in main.c
+int uart_receive_byte(void);
+void uart_send_string(const char* str);
+
+#define CMD_LINE_MAX 128   // Longest accepted UART line, including all ';' separated commands
+#define CMD_SEPARATOR ';'  // Separates several commands on one line
+#define CMD_LIST_MAX TRAJ_MAX_WAYPOINTS // Longest "POS/TRJ a,b,c" list accepted by the parser
 
 /* Command Types
  * Enumerates the types of commands that can be sent to the servo:
  * - CMD_SET_ON: Turn the servo on
  * - CMD_SET_OFF: Turn the servo off
- * - CMD_SET_POS: Set the servo position
+ * - CMD_SET_POS: Set the servo position (single value or comma separated list)
  * - CMD_SET_SPEED: Set the servo movement speed
+ * - CMD_GET: Query a value ("GET POS", "GET TGT", "GET SPD", "GET BUF", "GET STATE", "GET TRJ", "GET LAT")
+ * - CMD_TRAJ: Stream a precomputed path by DMA ("TRJ a,b,c,..."), "TRJ STOP" aborts it
  */
 typedef enum {
     CMD_SET_ON,    // Turn servo on
     CMD_SET_OFF,   // Turn servo off
     CMD_SET_POS,   // Set servo position
-    CMD_SET_SPEED  // Set servo speed
+    CMD_SET_SPEED, // Set servo speed
+    CMD_GET,       // Query servo state
+    CMD_TRAJ       // Start/stop a DMA trajectory
 } CommandType;
 
+/* Command Results
+ * Every command on a line produces exactly one response line:
+ * - CMD_OK: "OK" (GET commands answer with their value instead)
+ * - CMD_ERR_SYNTAX: "ERR SYNTAX" - unknown command or malformed argument
+ * - CMD_ERR_RANGE: "ERR RANGE" - value outside the servo limits
+ * - CMD_ERR_FULL: "ERR FULL" - position buffer has no room for the whole list
+ * - CMD_ERR_BUSY: "ERR BUSY" - a DMA trajectory owns the PWM output
+ */
+typedef enum {
+    CMD_OK,
+    CMD_ERR_SYNTAX,
+    CMD_ERR_RANGE,
+    CMD_ERR_FULL,
+    CMD_ERR_BUSY
+} CommandResult;
+
 /* Function Declarations
  * Core functions for processing user commands and monitoring servo state
  */
 
-// Process a single UART command and update the servo state accordingly
+// Process pending UART bytes and execute every complete command line
 void process_uart_command(ServoState* servo);
 
+// Execute one command (no separators) and send its response; the string is modified in place
+CommandResult execute_command(ServoState* servo, char* command);
+
 // Send the current servo state and buffer status over UART
 void send_monitoring_data(const ServoState* servo);
 
@@ -1,10 +1,14 @@
 #include "servo_control.h"
+#include "fxp_math.h" // Divide-free ratio constants
 
 #define PWM_MIN_DUTY 1000
 #define PWM_MAX_DUTY 2000
 #define SERVO_MIN_POS 0
 #define SERVO_MAX_POS 180
 
+// Compare counts per degree (Q16), exact for every position up to 2^16 / SERVO_MAX_POS
+#define DUTY_PER_POS_Q16 FXP_RATIO_Q16(PWM_MAX_DUTY - PWM_MIN_DUTY, SERVO_MAX_POS)
+
 /* Initialize servo state
  * Sets all servo parameters to their default values and
  * initializes the position buffer as empty
@@ -20,6 +24,7 @@ void servo_init(ServoState* servo) {
     servo->pos_buffer.head = 0; // Head of buffer starts at 0
     servo->pos_buffer.tail = 0; // Tail of buffer starts at 0
     servo->pos_buffer.count = 0; // Buffer count starts at 0
+    servo->target_stamp.enqueue = LATENCY_NO_STAMP; // No command in flight
 }
 
 /* Update servo position
@@ -28,15 +33,30 @@ void servo_init(ServoState* servo) {
  * 2. Updates target from buffer if current target is reached
  * 3. Moves current position towards target at specified speed
  * 4. Updates PWM duty cycle based on current position
+ * 5. Records command-to-pulse latency if a timestamped position was taken over
  */
 void servo_update(ServoState* servo) {
+    LatencyStamp stamp;          // Timestamp of the position taken over in this tick
+    uint32_t dequeue_time = 0;
+
     if (!servo->is_on) return; // Do nothing if servo is off
 
+    // Pick up a target that was set directly by servo_set_positions()
+    stamp = servo->target_stamp;
+    if (stamp.enqueue != LATENCY_NO_STAMP) {
+        servo->target_stamp.enqueue = LATENCY_NO_STAMP;
+        dequeue_time = latency_now();
+    }
+
     // Check if current target is reached and buffer has more positions
     if (servo->current_position_raw == servo->target_position_raw && 
         servo->pos_buffer.count > 0) {
         // Get next position from buffer
         servo->target_position_raw = servo->pos_buffer.buffer[servo->pos_buffer.tail];
+        if (servo->pos_buffer.stamp[servo->pos_buffer.tail].enqueue != LATENCY_NO_STAMP) {
+            stamp = servo->pos_buffer.stamp[servo->pos_buffer.tail];
+            dequeue_time = latency_now();
+        }
         servo->pos_buffer.tail = (servo->pos_buffer.tail + 1) % POSITION_BUFFER_SIZE;
         servo->pos_buffer.count--;
     }
@@ -57,9 +77,20 @@ void servo_update(ServoState* servo) {
     }
 
     // Convert position to PWM duty cycle and update hardware
-    servo->current_pwm_duty = PWM_MIN_DUTY + 
-        (servo->current_position_raw * (PWM_MAX_DUTY - PWM_MIN_DUTY) / SERVO_MAX_POS);
+    servo->current_pwm_duty = servo_position_to_duty(servo->current_position_raw);
     set_pwm_duty_cycle(servo->current_pwm_duty); // Update hardware with new duty cycle
+
+    if (stamp.enqueue != LATENCY_NO_STAMP) {
+        latency_record(&stamp, dequeue_time);
+    }
+}
+
+/* Convert position to PWM duty cycle
+ * Shared by servo_update() and the trajectory generator so both produce identical pulses
+ * One multiply and a shift: the Cortex-M0+ has no divide instruction
+ */
+uint16_t servo_position_to_duty(uint16_t position) {
+    return PWM_MIN_DUTY + (uint16_t)(((uint32_t)position * DUTY_PER_POS_Q16) >> 16);
 }
 
 /* Set servo power state
@@ -73,29 +104,77 @@ void servo_set_state(ServoState* servo, bool state) {
  * Returns false if buffer is full or position is invalid
  */
 bool servo_add_position_to_buffer(ServoState* servo, uint16_t position) {
-    if (servo->pos_buffer.count >= POSITION_BUFFER_SIZE || 
-        position > SERVO_MAX_POS) {
-        return false; // Return false if buffer is full or position is invalid
+    if (position > SERVO_MAX_POS) {
+        return false; // Return false if position is invalid
+    }
+
+    servo_enter_critical(); // A DMA interrupt ending a trajectory also updates the servo state
+    if (servo->pos_buffer.count >= POSITION_BUFFER_SIZE) {
+        servo_exit_critical();
+        return false; // Return false if buffer is full
     }
-    
     servo->pos_buffer.buffer[servo->pos_buffer.head] = position; // Add position to buffer
+    servo->pos_buffer.stamp[servo->pos_buffer.head].enqueue = LATENCY_NO_STAMP; // Not from a timed command
     servo->pos_buffer.head = (servo->pos_buffer.head + 1) % POSITION_BUFFER_SIZE; // Update buffer head
     servo->pos_buffer.count++; // Increment buffer count
+    servo_exit_critical();
     return true; // Return true if position was successfully added
 }
 
+/* Number of free buffer slots
+ * Snapshot only outside a critical section: the servo task may free more slots before the caller uses it
+ */
+uint8_t servo_buffer_free(const ServoState* servo) {
+    return POSITION_BUFFER_SIZE - servo->pos_buffer.count;
+}
+
 /* Set new target position
  * If buffer is empty, sets immediate target
  * Otherwise, adds to position buffer
+ * Returns false if the position is invalid or the buffer is full
  */
-void servo_set_position(ServoState* servo, uint16_t position) {
-    if (position <= SERVO_MAX_POS) { // Check if position is valid
-        if (servo->pos_buffer.count == 0) {
-            servo->target_position_raw = position; // Set immediate target if buffer is empty
-        } else {
-            servo_add_position_to_buffer(servo, position); // Add position to buffer
-        }
+bool servo_set_position(ServoState* servo, uint16_t position) {
+    return servo_set_positions(servo, &position, 1);
+}
+
+/* Set a list of target positions
+ * The whole list is validated and checked against the free buffer space first,
+ * then applied inside one critical section so an interrupt never sees a partial list.
+ * The first position becomes the immediate target if the buffer is empty,
+ * exactly as with consecutive servo_set_position() calls.
+ */
+bool servo_set_positions(ServoState* servo, const uint16_t* positions, uint8_t count) {
+    if (count == 0) return false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (positions[i] > SERVO_MAX_POS) return false; // Reject the whole list on any invalid entry
+    }
+
+    servo_enter_critical();
+    uint8_t first = (servo->pos_buffer.count == 0) ? 1 : 0; // First entry bypasses an empty buffer
+    if (count - first > servo_buffer_free(servo)) {
+        servo_exit_critical();
+        return false; // Not enough room for the whole list
+    }
+
+    // Only the first position carries the command timestamp, and only if the servo will act on it
+    LatencyStamp stamp;
+    stamp.enqueue = LATENCY_NO_STAMP;
+    if (servo->is_on) latency_command_enqueued(&stamp);
+
+    if (first) {
+        servo->target_position_raw = positions[0]; // Set immediate target if buffer is empty
+        servo->target_stamp = stamp;
+        stamp.enqueue = LATENCY_NO_STAMP;
+    }
+    for (uint8_t i = first; i < count; i++) {
+        servo->pos_buffer.buffer[servo->pos_buffer.head] = positions[i];
+        servo->pos_buffer.stamp[servo->pos_buffer.head] = stamp;
+        servo->pos_buffer.head = (servo->pos_buffer.head + 1) % POSITION_BUFFER_SIZE;
+        stamp.enqueue = LATENCY_NO_STAMP;
     }
+    servo->pos_buffer.count += count - first;
+    servo_exit_critical();
+    return true;
 }
 
 /* Set servo movement speed
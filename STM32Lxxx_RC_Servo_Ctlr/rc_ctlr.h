@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "rc_latency.h"
 
 /* PWM Configuration Constants
  * PWM_MIN/MAX_DUTY: Define the pulse width range for servo control (in microseconds)
@@ -20,6 +21,7 @@
  */
 typedef struct {
     uint16_t buffer[POSITION_BUFFER_SIZE];  // Array to store position values
+    LatencyStamp stamp[POSITION_BUFFER_SIZE]; // Command timestamps travelling with each position
     uint8_t head;     // Index for next write position
     uint8_t tail;     // Index for next read position
     uint8_t count;    // Number of positions currently in buffer
@@ -39,6 +41,7 @@ typedef struct {
     uint16_t current_pwm_duty;     // Current PWM duty cycle
     uint8_t moving_speed;          // Movement speed (positions per update)
     PositionBuffer pos_buffer;     // Buffer for queued positions
+    LatencyStamp target_stamp;     // Timestamp of a target set directly (bypassing the buffer)
 } ServoState;
 
 /* Function Declarations
@@ -51,11 +54,19 @@ void servo_init(ServoState* servo);
 // Update servo position based on current state and parameters
 void servo_update(ServoState* servo);
 
+// Convert an angular position to the PWM compare value
+uint16_t servo_position_to_duty(uint16_t position);
+
 // Set servo power state (ON/OFF)
 void servo_set_state(ServoState* servo, bool state);
 
 // Set new target position (immediate or buffered)
-void servo_set_position(ServoState* servo, uint16_t position);
+// Returns false if the position is invalid or the buffer is full
+bool servo_set_position(ServoState* servo, uint16_t position);
+
+// Set a list of target positions in one atomic operation
+// Either every position is accepted or none is (invalid position or not enough buffer space)
+bool servo_set_positions(ServoState* servo, const uint16_t* positions, uint8_t count);
 
 // Set servo movement speed
 void servo_set_speed(ServoState* servo, uint8_t speed);
@@ -63,4 +74,16 @@ void servo_set_speed(ServoState* servo, uint8_t speed);
 // Add a new position to the buffer queue
 bool servo_add_position_to_buffer(ServoState* servo, uint16_t position);
 
+// Number of free slots left in the position buffer
+uint8_t servo_buffer_free(const ServoState* servo);
+
+/* Hardware Hooks
+ * Implemented next to the other HAL placeholders in main.c
+ * servo_update() runs as an executive task (main.c) and never preempts the command task;
+ * the critical section must mask the trajectory DMA interrupts
+ */
+void set_pwm_duty_cycle(uint16_t duty_cycle);
+void servo_enter_critical(void);
+void servo_exit_critical(void);
+
 #endif // SERVO_CONTROL_H
@@ -0,0 +1,108 @@
+#include "rc_latency.h"
+#include <stdio.h>
+
+void uart_send_string(const char* str); // UART hook (main.c)
+
+static const char* const stage_name[LAT_STAGE_COUNT] = {
+    "PARSE", "ENQUEUE", "DEQUEUE", "WRITE"
+};
+
+static LatencyStamp current;                 // Stamp of the command being processed
+static bool current_valid = false;           // current not yet handed to a position
+static LatencyStats stats[LAT_STAGE_COUNT];  // Written by the servo task, read by latency_report()
+
+/* Histogram bucket of a latency
+ * floor(log2(ticks)) + 1 with a branch-only binary search (no CLZ on Cortex-M0+)
+ */
+static uint8_t latency_bucket(uint32_t ticks) {
+    uint8_t bucket = 0;
+    if (ticks == 0) return 0;
+    if (ticks >= 1UL << 16) { ticks >>= 16; bucket += 16; }
+    if (ticks >= 1UL << 8)  { ticks >>= 8;  bucket += 8; }
+    if (ticks >= 1UL << 4)  { ticks >>= 4;  bucket += 4; }
+    if (ticks >= 1UL << 2)  { ticks >>= 2;  bucket += 2; }
+    if (ticks >= 1UL << 1)  { bucket += 1; }
+    bucket += 1;
+    return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+static void latency_add(LatencyStage stage, uint32_t ticks) {
+    LatencyStats* s = &stats[stage];
+    if (s->count == 0 || ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+    s->count++;
+    s->sum += ticks;
+    uint8_t bucket = latency_bucket(ticks);
+    if (s->histogram[bucket] < 0xFFFF) s->histogram[bucket]++; // Saturate instead of wrapping
+}
+
+void latency_command_received(void) {
+    current.rx = latency_now();
+    current.parse = 0;
+    current.enqueue = LATENCY_NO_STAMP;
+    current_valid = true;
+}
+
+void latency_command_parsed(void) {
+    uint32_t dt = latency_now() - current.rx;
+    current.parse = (dt < LATENCY_NO_STAMP) ? (uint16_t)dt : LATENCY_NO_STAMP - 1;
+}
+
+/* Stamp a position being enqueued
+ * Only the first position of a line is stamped; later list entries or commands
+ * would only measure how long the earlier positions took to execute
+ */
+void latency_command_enqueued(LatencyStamp* stamp) {
+    uint32_t dt = latency_now() - current.rx;
+    *stamp = current;
+    if (!current_valid) {
+        stamp->enqueue = LATENCY_NO_STAMP; // Already used by an earlier position of this command
+        return;
+    }
+    stamp->enqueue = (dt < LATENCY_NO_STAMP) ? (uint16_t)dt : LATENCY_NO_STAMP - 1;
+    current_valid = false;
+}
+
+/* Record one complete command-to-pulse path
+ * Called from servo_update() right after the duty write; costs one timer read
+ * and four histogram updates
+ */
+void latency_record(const LatencyStamp* stamp, uint32_t dequeue_time) {
+    if (stamp->enqueue == LATENCY_NO_STAMP) return;
+    uint32_t write_time = latency_now();
+    latency_add(LAT_STAGE_PARSE, stamp->parse);
+    latency_add(LAT_STAGE_ENQUEUE, stamp->enqueue);
+    latency_add(LAT_STAGE_DEQUEUE, dequeue_time - stamp->rx);
+    latency_add(LAT_STAGE_WRITE, write_time - stamp->rx);
+}
+
+void latency_reset(void) {
+    for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+        LatencyStats* s = &stats[i];
+        s->count = s->min = s->max = 0;
+        s->sum = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) s->histogram[b] = 0;
+    }
+}
+
+/* Send Latency Statistics
+ * One line per stage: "LAT <stage> n=<count> min=<us> avg=<us> max=<us> h=<b0>,<b1>,..."
+ * Histogram bucket n covers [2^(n-1), 2^n) ticks
+ */
+void latency_report(void) {
+    char buffer[200];
+    for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+        LatencyStats s = stats[i]; // Snapshot; the servo task cannot run while we print
+        uint32_t avg = s.count ? (uint32_t)(s.sum / s.count) : 0;
+        int len = snprintf(buffer, sizeof(buffer), "LAT %s n=%lu min=%lu avg=%lu max=%lu h=",
+                           stage_name[i], (unsigned long)s.count,
+                           (unsigned long)(s.min * LATENCY_TICK_US),
+                           (unsigned long)(avg * LATENCY_TICK_US),
+                           (unsigned long)(s.max * LATENCY_TICK_US));
+        for (int b = 0; b < LATENCY_BUCKETS && len < (int)sizeof(buffer) - 8; b++) {
+            len += snprintf(&buffer[len], sizeof(buffer) - len, b ? ",%u" : "%u", s.histogram[b]);
+        }
+        snprintf(&buffer[len], sizeof(buffer) - len, "\n");
+        uart_send_string(buffer);
+    }
+}
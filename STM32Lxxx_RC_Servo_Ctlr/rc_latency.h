@@ -0,0 +1,70 @@
+#ifndef SERVO_LATENCY_H
+#define SERVO_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Latency Instrumentation Configuration
+ * LATENCY_TICK_US: resolution of latency_now() in microseconds
+ * LATENCY_BUCKETS: log2 histogram buckets; bucket n counts latencies in [2^(n-1), 2^n) ticks,
+ *                  bucket 0 counts zero, the last bucket collects everything above
+ * LATENCY_NO_STAMP: marks a queued position that carries no timestamp
+ */
+#define LATENCY_TICK_US 1
+#define LATENCY_BUCKETS 20
+#define LATENCY_NO_STAMP 0xFFFF
+
+/* Measured Stages
+ * Every stage is measured from the arrival of the line terminator:
+ * - LAT_STAGE_PARSE: command parsed
+ * - LAT_STAGE_ENQUEUE: position stored as target or in the ring buffer
+ * - LAT_STAGE_DEQUEUE: position picked up by servo_update() in the servo task
+ * - LAT_STAGE_WRITE: new duty written to the PWM compare register
+ */
+typedef enum {
+    LAT_STAGE_PARSE,
+    LAT_STAGE_ENQUEUE,
+    LAT_STAGE_DEQUEUE,
+    LAT_STAGE_WRITE,
+    LAT_STAGE_COUNT
+} LatencyStage;
+
+/* Command Timestamp
+ * Travels with a position through the ring buffer (8 bytes per slot)
+ * parse/enqueue are offsets from rx so the stamp stays small
+ */
+typedef struct {
+    uint32_t rx;      // latency_now() when the line terminator was processed
+    uint16_t parse;   // Ticks from rx to parse complete
+    uint16_t enqueue; // Ticks from rx to enqueue, LATENCY_NO_STAMP if not stamped
+} LatencyStamp;
+
+/* Per-stage Statistics */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;     // 64 bits: a uint32_t wraps after ~4.3e9 ticks of summed latency
+    uint16_t histogram[LATENCY_BUCKETS];
+} LatencyStats;
+
+/* Function Declarations */
+
+// Command side (main loop context)
+void latency_command_received(void);        // Line terminator seen
+void latency_command_parsed(void);          // Command decoded
+void latency_command_enqueued(LatencyStamp* stamp); // Fill stamp for the position being enqueued
+
+// Servo task side: position taken over as target at dequeue_time and its duty written now
+void latency_record(const LatencyStamp* stamp, uint32_t dequeue_time);
+
+// Clear all statistics
+void latency_reset(void);
+
+// Send the statistics of every stage over UART
+void latency_report(void);
+
+// Free-running timestamp source in LATENCY_TICK_US units (implemented in main.c)
+uint32_t latency_now(void);
+
+#endif // SERVO_LATENCY_H
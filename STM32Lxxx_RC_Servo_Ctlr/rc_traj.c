@@ -0,0 +1,130 @@
+#include "rc_traj.h"
+
+#define TRAJ_BUFFER_SIZE (2 * TRAJ_HALF_SIZE)
+
+/* Advance the generator by one PWM period
+ * Uses exactly the stepping rule of servo_update() so a DMA trajectory
+ * produces the same pulses as the interrupt driven path would.
+ * Returns false once the last waypoint has been reached.
+ */
+static bool traj_step(ServoTrajectory* traj) {
+    if (traj->position == traj->target) {
+        if (traj->waypoint_index >= traj->waypoint_count) {
+            return false; // Path finished
+        }
+        traj->target = traj->waypoints[traj->waypoint_index++];
+    }
+
+    if (traj->position < traj->target) {
+        traj->position += traj->speed;
+        if (traj->position > traj->target) traj->position = traj->target; // Prevent overshooting
+    } else if (traj->position > traj->target) {
+        traj->position = (traj->position - traj->target > traj->speed) ?
+                         traj->position - traj->speed : traj->target; // Prevent overshooting
+    }
+    return true;
+}
+
+/* Fill one half of the DMA buffer
+ * Once the path is finished the remaining slots hold the final compare value
+ */
+static void traj_fill_half(ServoTrajectory* traj, uint8_t half) {
+    uint16_t* dst = &traj->dma_buffer[half * TRAJ_HALF_SIZE];
+    bool motion = false;
+
+    for (uint16_t i = 0; i < TRAJ_HALF_SIZE; i++) {
+        if (traj_step(traj)) motion = true;
+        dst[i] = servo_position_to_duty(traj->position);
+    }
+    traj->half_has_motion[half] = motion;
+}
+
+/* Convert a compare value back to a position
+ * Exact inverse of servo_position_to_duty() for every valid position
+ */
+static uint16_t traj_duty_to_position(uint16_t duty) {
+    return (uint16_t)(((uint32_t)(duty - PWM_MIN_DUTY) * (SERVO_MAX_POS - SERVO_MIN_POS) + 500) /
+                      (PWM_MAX_DUTY - PWM_MIN_DUTY));
+}
+
+/* Hand the compare register back to servo_update() */
+static void traj_finish(ServoTrajectory* traj, ServoState* servo, uint16_t position) {
+    traj->active = false;
+    servo->current_position_raw = position;
+    servo->target_position_raw = position;
+    servo->current_pwm_duty = servo_position_to_duty(position);
+}
+
+/* Refill the half that has just been played
+ * Streaming stops once neither half holds motion samples; the compare register
+ * keeps the final value so the servo holds the last waypoint.
+ */
+static void traj_half_played(ServoTrajectory* traj, ServoState* servo, uint8_t half) {
+    if (!traj->active) return;
+
+    traj_fill_half(traj, half);
+    if (!traj->half_has_motion[0] && !traj->half_has_motion[1]) {
+        pwm_dma_stop();
+        traj_finish(traj, servo, traj->position);
+    }
+}
+
+/* Start a DMA trajectory
+ * The path starts from the servo's current position with its current moving speed.
+ * The servo must be on and at its target: the trajectory end becomes the new target, so a
+ * pending move would be lost. Queued buffer positions are left untouched and resume after it.
+ */
+bool servo_traj_start(ServoTrajectory* traj, ServoState* servo,
+                      const uint16_t* waypoints, uint8_t count) {
+    if (!servo->is_on || traj->active || count == 0 || count > TRAJ_MAX_WAYPOINTS) return false;
+    if (servo->current_position_raw != servo->target_position_raw) return false; // Move pending
+    for (uint8_t i = 0; i < count; i++) {
+        if (waypoints[i] > SERVO_MAX_POS) return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        traj->waypoints[i] = waypoints[i];
+    }
+    traj->waypoint_count = count;
+    traj->waypoint_index = 0;
+    traj->position = servo->current_position_raw;
+    traj->target = servo->current_position_raw;
+    traj->speed = servo->moving_speed;
+
+    // Precompute both halves before the first DMA request
+    traj_fill_half(traj, 0);
+    traj_fill_half(traj, 1);
+
+    servo_enter_critical(); // servo_update() must not write the compare register from now on
+    traj->active = true;
+    servo_exit_critical();
+    pwm_dma_start(traj->dma_buffer, TRAJ_BUFFER_SIZE);
+    return true;
+}
+
+/* Abort a running trajectory
+ * The position handed back is the one belonging to the compare value the DMA loaded last
+ */
+void servo_traj_abort(ServoTrajectory* traj, ServoState* servo) {
+    if (!traj->active) return;
+
+    uint16_t remaining = pwm_dma_stop();
+    uint16_t next = (TRAJ_BUFFER_SIZE - remaining) % TRAJ_BUFFER_SIZE;
+    uint16_t last = (next + TRAJ_BUFFER_SIZE - 1) % TRAJ_BUFFER_SIZE;
+
+    servo_enter_critical();
+    traj_finish(traj, servo, traj_duty_to_position(traj->dma_buffer[last]));
+    servo_exit_critical();
+}
+
+void servo_traj_dma_half_complete(ServoTrajectory* traj, ServoState* servo) {
+    traj_half_played(traj, servo, 0);
+}
+
+void servo_traj_dma_complete(ServoTrajectory* traj, ServoState* servo) {
+    traj_half_played(traj, servo, 1);
+}
+
+bool servo_traj_active(const ServoTrajectory* traj) {
+    return traj->active;
+}
@@ -0,0 +1,65 @@
+#ifndef SERVO_TRAJECTORY_H
+#define SERVO_TRAJECTORY_H
+
+#include "servo_control.h"
+
+/* DMA Trajectory Configuration
+ * TRAJ_HALF_SIZE: compare values per DMA half buffer (one refill covers this many PWM periods)
+ * TRAJ_MAX_WAYPOINTS: longest path accepted by servo_traj_start()
+ */
+#define TRAJ_HALF_SIZE 32
+#define TRAJ_MAX_WAYPOINTS 32
+
+/* Trajectory Structure
+ * Holds a precomputed path that the PWM timer streams to its compare register by DMA.
+ * The DMA runs in circular mode over dma_buffer; each half is refilled from the
+ * half-transfer / transfer-complete interrupts while the other half is being played,
+ * so the CPU does no work per PWM period and arbitrarily long paths fit.
+ */
+typedef struct {
+    uint16_t dma_buffer[2 * TRAJ_HALF_SIZE]; // Compare values streamed to CCR (double buffer)
+    bool half_has_motion[2];                 // Half still holds samples of the moving part
+
+    uint16_t waypoints[TRAJ_MAX_WAYPOINTS];  // Path to follow
+    uint8_t waypoint_count;                  // Number of valid waypoints
+    uint8_t waypoint_index;                  // Next waypoint to become the target
+
+    uint16_t position;                       // Generator position (same units as servo position)
+    uint16_t target;                         // Generator target
+    uint8_t speed;                           // Position units per PWM period
+    volatile bool active;                    // DMA streaming in progress
+} ServoTrajectory;
+
+// Trajectory instance used by the timer/DMA handlers and the command parser (defined in main.c)
+extern ServoTrajectory servo_traj;
+
+/* Function Declarations */
+
+// Precompute the first two halves and start DMA streaming from the servo's current position
+// Returns false if the servo is off, still moving to a target, a trajectory is already running,
+// or the path is empty/too long/invalid
+bool servo_traj_start(ServoTrajectory* traj, ServoState* servo,
+                      const uint16_t* waypoints, uint8_t count);
+
+// Stop streaming immediately and hand the last streamed position back to servo_update()
+void servo_traj_abort(ServoTrajectory* traj, ServoState* servo);
+
+// Call from the DMA half-transfer interrupt (first half has been played)
+void servo_traj_dma_half_complete(ServoTrajectory* traj, ServoState* servo);
+
+// Call from the DMA transfer-complete interrupt (second half has been played)
+void servo_traj_dma_complete(ServoTrajectory* traj, ServoState* servo);
+
+// True while the DMA owns the compare register (servo_update() must not run)
+bool servo_traj_active(const ServoTrajectory* traj);
+
+/* Hardware Hooks
+ * Implemented next to the other HAL placeholders in main.c
+ * pwm_dma_start: circular half-word DMA from memory to CCRx on the timer update request,
+ *                half-transfer and transfer-complete interrupts enabled
+ * pwm_dma_stop: disable the DMA request and return the remaining transfer count (CNDTR)
+ */
+void pwm_dma_start(const uint16_t* buffer, uint16_t length);
+uint16_t pwm_dma_stop(void);
+
+#endif // SERVO_TRAJECTORY_H
@@ -0,0 +1,533 @@
+/*
+ * dcm_fit: fits R, L, Ke, J, B and Tc jointly to one recorded voltage chirp (CAP_PHASE_CHIRP).
+ *
+ * Build (from STM32_DCM_Param_Estm/):
+ *   cc -O2 -std=gnu99 -Ihost -I. host/dcm_fit.c -lm -o dcm_fit
+ *
+ * Usage:
+ *   dcm_fit [-j workers] [-n starts] [-s seed] <file.dcmc>...
+ *
+ * The applied voltage is regenerated bit for bit from the phase record (ChirpResult in
+ * motor_lockin.h). The model
+ *   L di/dt = V - R*i - Ke*w,   J dw/dt = Ke*i - B*w - Tc*sign(w)   (Kt = Ke in SI units)
+ * is simulated at the current sample rate, with the shaft sticking while |Ke*i| <= Tc, and
+ * fitted to the measured current and velocity by Levenberg-Marquardt in log parameters.
+ * Every start is drawn log-uniformly within a decade of the values the device had when the
+ * chirp began (two decades around typical values where it had none); the starts are split
+ * across worker processes. The best fit is printed with 95 % confidence intervals from the
+ * Jacobian at the optimum, in the units of the firmware globals (motor_R ... motor_Tc).
+ * The intervals assume white residuals; model error makes them optimistic.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "motor_lockin.h"
+#include "motor_encoder.h"
+#include "motor_capture.h"
+
+#define FIT_PARAMS 6U
+#define FIT_MAX_ITER 200U
+#define FIT_BASIN_TOL 0.01   // Starts within 1 % of the best cost count as converged to it
+#define FIT_LOG_MIN -30.0    // Parameter floor, e^-30 (Tc and B may well be zero)
+
+static const char *param_name[FIT_PARAMS] = { "motor_R", "motor_L", "motor_Ke", "motor_J", "motor_B", "motor_Tc" };
+static const char *param_unit[FIT_PARAMS] = { "Ohms", "H", "V/(rad/s)", "kg*m^2", "Nm/(rad/s)", "Nm" };
+static const double param_typical[FIT_PARAMS] = { 1.0, 1e-3, 0.05, 1e-5, 1e-5, 1e-3 };
+
+// --- Chirp Capture ---
+typedef struct {
+    float params[4];      // A, f_start, f_end, duration
+    float snapshot[6];    // R, L, Ke, Kt, J, B when the phase began
+    float results[4];     // growth, samples, amp (bridge counts), velocity_lost
+    uint32_t zero;        // First flush: excitation applied
+    bool have_zero, ended, ok;
+    uint32_t n;           // Samples fitted (current rate)
+    double f_end_hz;      // Frequency reached by the regenerated step
+    double *v;            // Applied voltage (V)
+    double *i;            // Measured current (A), NAN where dropped
+    uint32_t vel_n;
+    uint32_t vel_rate;
+    double *w;            // Measured velocity (rad/s), NAN where dropped
+} Chirp;
+
+typedef struct {
+    uint16_t adc_resolution;
+    float v_ref;
+    float shunt;
+    float v_supply;
+    uint32_t adc_rate_hz;
+    uint32_t pwm_arr;
+    uint16_t adc_offset;
+} StreamInfo;
+
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static float get_f32(const uint8_t *p) { uint32_t u = get_u32(p); float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+static void *xcalloc(size_t n, size_t size) {
+    void *p = calloc(n ? n : 1, size);
+    if (!p) { perror("calloc"); exit(1); }
+    return p;
+}
+
+// Applied voltage of every sample, the same integer generator as lockin_pwm_update()
+static void chirp_voltage(Chirp *c, const StreamInfo *info) {
+    int16_t sine_table[LOCKIN_TABLE_SIZE];
+    for (uint32_t k = 0; k < LOCKIN_TABLE_SIZE; k++) {
+        sine_table[k] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * (float)k / LOCKIN_TABLE_SIZE));
+    }
+    uint32_t amp = (uint32_t)c->results[2];
+    uint32_t step0 = (uint32_t)(c->params[1] / info->adc_rate_hz * 4294967296.0f + 0.5f);
+    uint32_t growth = (uint32_t)c->results[0];
+    uint32_t played = (uint32_t)c->results[1];
+    uint64_t step = (uint64_t)step0 << CHIRP_STEP_FRAC_BITS;
+    uint32_t phase = 0;
+    for (uint32_t k = 0; k < c->n; k++) {
+        if (k >= played) { c->v[k] = 0.0; continue; }
+        int32_t s = sine_table[phase >> (32U - LOCKIN_TABLE_BITS)];
+        c->v[k] = (double)(((int32_t)amp * s) >> 15) * info->v_supply / info->pwm_arr;
+        uint32_t st = (uint32_t)(step >> CHIRP_STEP_FRAC_BITS);
+        phase += st;
+        step += ((uint64_t)st * growth) >> CHIRP_STEP_FRAC_BITS;
+    }
+    c->f_end_hz = (double)(step >> CHIRP_STEP_FRAC_BITS) / 4294967296.0 * info->adc_rate_hz;
+}
+
+// Reads the stream header and the first completed chirp phase after skip earlier ones
+static bool load_chirp(const char *path, uint32_t skip, Chirp *c, StreamInfo *info) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = xcalloc(size > 0 ? (size_t)size : 1U, 1);
+    size_t got = fread(buf, 1, (size_t)size, f);
+    fclose(f);
+
+    // Pass 1: find the phase and its extent; pass 2: fill the samples
+    bool have_stream = false, found = false;
+    for (int pass = 0; pass < 2 && !(pass == 1 && !found); pass++) {
+        size_t pos = 0;
+        bool inside = false;
+        uint32_t seen = 0;
+        while (pos + 4 <= got) {
+            uint8_t type = buf[pos], tag = buf[pos + 1];
+            uint16_t len = get_u16(&buf[pos + 2]);
+            const uint8_t *p = &buf[pos + 4];
+            if (pos + 4 + len > got) break;
+            pos += 4U + len;
+
+            if (type == CAP_REC_STREAM && len >= 30 && get_u32(p) == CAPTURE_MAGIC) {
+                info->adc_resolution = get_u16(p + 6);
+                info->v_ref = get_f32(p + 8);
+                info->shunt = get_f32(p + 12);
+                info->v_supply = get_f32(p + 16);
+                info->adc_rate_hz = get_u32(p + 20);
+                info->pwm_arr = get_u32(p + 24);
+                info->adc_offset = get_u16(p + 28);
+                have_stream = true;
+            } else if (type == CAP_REC_PHASE_BEGIN) {
+                inside = (tag == CAP_PHASE_CHIRP && len >= 48 && seen++ == skip);
+                if (inside && pass == 0) {
+                    memset(c, 0, sizeof(*c));
+                    for (int k = 0; k < 4; k++) c->params[k] = get_f32(p + 8 + 4 * k);
+                    for (int k = 0; k < 6; k++) c->snapshot[k] = get_f32(p + 24 + 4 * k);
+                }
+            } else if (!inside) {
+                continue;
+            } else if (type == CAP_REC_FLUSH && len >= 4) {
+                if (pass == 0 && !c->have_zero) { c->zero = get_u32(p); c->have_zero = true; }
+            } else if (type == CAP_REC_CURRENT && len >= 4 && pass == 1) {
+                uint32_t index = get_u32(p);
+                for (uint32_t k = 0; k < (len - 4U) / 2U; k++) {
+                    uint32_t n = index + k - c->zero;
+                    if (index + k < c->zero || n >= c->n) continue;
+                    c->i[n] = ((double)get_u16(p + 4 + 2 * k) - info->adc_offset) / info->adc_resolution *
+                              info->v_ref / info->shunt;
+                }
+            } else if (type == CAP_REC_VELOCITY && len >= 8 && pass == 1) {
+                uint32_t first = get_u32(p);
+                for (uint32_t k = 0; k < (len - 8U) / 4U; k++) {
+                    if (first + k < c->vel_n) c->w[first + k] = get_f32(p + 8 + 4 * k);
+                }
+            } else if (type == CAP_REC_VELOCITY && len >= 8) {
+                c->vel_rate = get_u32(p + 4);
+            } else if (type == CAP_REC_PHASE_END && tag == CAP_PHASE_CHIRP && len >= 28) {
+                if (pass == 0) {
+                    c->ok = get_u32(p + 8) != 0;
+                    for (int k = 0; k < 4; k++) c->results[k] = get_f32(p + 12 + 4 * k);
+                    c->ended = true;
+                    found = true;
+                }
+                inside = false;
+            }
+        }
+
+        if (pass == 0 && found) {
+            c->n = (uint32_t)c->results[1];
+            c->vel_n = c->vel_rate ? c->n / (info->adc_rate_hz / c->vel_rate) : 0;
+            c->v = xcalloc(c->n, sizeof(double));
+            c->i = xcalloc(c->n, sizeof(double));
+            c->w = xcalloc(c->vel_n, sizeof(double));
+            for (uint32_t k = 0; k < c->n; k++) c->i[k] = NAN;
+            for (uint32_t k = 0; k < c->vel_n; k++) c->w[k] = NAN;
+        }
+    }
+    free(buf);
+    if (!have_stream) fprintf(stderr, "%s: not a capture stream\n", path);
+    if (!found || !c->ok || !c->have_zero || c->n == 0) return false;
+    chirp_voltage(c, info);
+    return true;
+}
+
+// --- Model ---
+typedef struct {
+    const Chirp *c;
+    double dt;
+    uint32_t decim;       // Current samples per velocity sample
+    double scale_i;       // Residual weights (1 / A, 1 / (rad/s))
+    double scale_w;
+    uint32_t rows;        // Valid current + velocity samples
+    double *i_sim;        // Scratch: simulated current
+    double *w_sim;        //          simulated velocity
+} Problem;
+
+// Simulates the chirp with parameters x (log) and writes the weighted residuals (rows entries)
+static void residuals(const Problem *pb, const double *x, double *r) {
+    const Chirp *c = pb->c;
+    double R = exp(x[0]), L = exp(x[1]), Ke = exp(x[2]), J = exp(x[3]), B = exp(x[4]), Tc = exp(x[5]);
+
+    // Exact zero-order-hold steps of both first-order parts, coupled once per sample
+    double a_i = exp(-R * pb->dt / L);
+    double a_w = exp(-B * pb->dt / J);
+    double g_w = -expm1(-B * pb->dt / J) / B; // (1 - a_w) / B, finite for B -> 0
+
+    double i = 0.0, w = 0.0;
+    for (uint32_t k = 0; k < c->n; k++) {
+        if (!isnan(c->i[k])) { i = c->i[k]; break; }
+    }
+    if (c->vel_n > 0 && !isnan(c->w[0])) w = c->w[0];
+
+    for (uint32_t k = 0; k < c->n; k++) {
+        pb->i_sim[k] = i;
+        pb->w_sim[k] = w;
+        // The voltage written in period k - 1 drives the winding up to sample k + 1 (compare preload)
+        double v = (k > 0) ? c->v[k - 1] : 0.0;
+        double i_next = a_i * i + (1.0 - a_i) * (v - Ke * w) / R;
+        double torque = Ke * 0.5 * (i + i_next);
+        i = i_next;
+
+        if (w == 0.0 && fabs(torque) <= Tc) continue; // Stuck
+        double s = (w != 0.0) ? copysign(1.0, w) : copysign(1.0, torque);
+        double w_next = a_w * w + g_w * (torque - Tc * s);
+        if (w != 0.0 && w_next * w < 0.0) w_next = 0.0; // Friction stops the shaft within the step
+        w = w_next;
+    }
+
+    uint32_t row = 0;
+    for (uint32_t k = 0; k < c->n; k++) {
+        if (!isnan(c->i[k])) r[row++] = (pb->i_sim[k] - c->i[k]) * pb->scale_i;
+    }
+    // Velocity sample j is the encoder's mean over the update before PWM period j * decim
+    for (uint32_t j = 1; j < c->vel_n; j++) {
+        if (isnan(c->w[j])) continue;
+        double mean = 0.0;
+        for (uint32_t k = j * pb->decim - ENC_UPDATE_DECIM; k < j * pb->decim; k++) mean += pb->w_sim[k];
+        r[row++] = (mean / ENC_UPDATE_DECIM - c->w[j]) * pb->scale_w;
+    }
+}
+
+static double sum_sq(const double *r, uint32_t n) {
+    double s = 0.0;
+    for (uint32_t k = 0; k < n; k++) s += r[k] * r[k];
+    return s;
+}
+
+// Forward-difference Jacobian (column-major, rows x FIT_PARAMS) around x with residuals r0
+static void jacobian(const Problem *pb, const double *x, const double *r0, double *jac) {
+    for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+        double xp[FIT_PARAMS];
+        memcpy(xp, x, sizeof(xp));
+        const double h = 1e-5;
+        xp[p] += h;
+        double *col = jac + (size_t)p * pb->rows;
+        residuals(pb, xp, col);
+        for (uint32_t k = 0; k < pb->rows; k++) col[k] = (col[k] - r0[k]) / h;
+    }
+}
+
+// J'J and J'r
+static void normal_equations(const double *jac, const double *r, uint32_t rows,
+                             double a[FIT_PARAMS][FIT_PARAMS], double g[FIT_PARAMS]) {
+    for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+        const double *cp = jac + (size_t)p * rows;
+        g[p] = 0.0;
+        for (uint32_t k = 0; k < rows; k++) g[p] += cp[k] * r[k];
+        for (uint32_t q = 0; q <= p; q++) {
+            const double *cq = jac + (size_t)q * rows;
+            double s = 0.0;
+            for (uint32_t k = 0; k < rows; k++) s += cp[k] * cq[k];
+            a[p][q] = a[q][p] = s;
+        }
+    }
+}
+
+// Solves m * x = b in place (Gaussian elimination with partial pivoting); false if singular
+static bool solve(double m[FIT_PARAMS][FIT_PARAMS], double b[FIT_PARAMS]) {
+    for (uint32_t c = 0; c < FIT_PARAMS; c++) {
+        uint32_t piv = c;
+        for (uint32_t r = c + 1; r < FIT_PARAMS; r++) if (fabs(m[r][c]) > fabs(m[piv][c])) piv = r;
+        if (fabs(m[piv][c]) < 1e-300) return false;
+        for (uint32_t k = 0; k < FIT_PARAMS; k++) { double t = m[c][k]; m[c][k] = m[piv][k]; m[piv][k] = t; }
+        double t = b[c]; b[c] = b[piv]; b[piv] = t;
+        for (uint32_t r = c + 1; r < FIT_PARAMS; r++) {
+            double f = m[r][c] / m[c][c];
+            for (uint32_t k = c; k < FIT_PARAMS; k++) m[r][k] -= f * m[c][k];
+            b[r] -= f * b[c];
+        }
+    }
+    for (int c = FIT_PARAMS - 1; c >= 0; c--) {
+        for (uint32_t k = (uint32_t)c + 1; k < FIT_PARAMS; k++) b[c] -= m[c][k] * b[k];
+        b[c] /= m[c][c];
+    }
+    return true;
+}
+
+// --- Levenberg-Marquardt ---
+typedef struct {
+    uint32_t start;
+    double x[FIT_PARAMS];
+    double cost;
+    uint32_t iterations;
+} StartResult;
+
+static void lm_fit(const Problem *pb, double *x, StartResult *res) {
+    double *r = xcalloc(pb->rows, sizeof(double));
+    double *r_try = xcalloc(pb->rows, sizeof(double));
+    double *jac = xcalloc((size_t)pb->rows * FIT_PARAMS, sizeof(double));
+    double a[FIT_PARAMS][FIT_PARAMS], g[FIT_PARAMS];
+    double lambda = 1e-3;
+
+    residuals(pb, x, r);
+    double cost = sum_sq(r, pb->rows);
+    uint32_t it;
+    for (it = 0; it < FIT_MAX_ITER; it++) {
+        jacobian(pb, x, r, jac);
+        normal_equations(jac, r, pb->rows, a, g);
+
+        bool improved = false;
+        double x_try[FIT_PARAMS], cost_try = cost;
+        while (lambda < 1e10) {
+            double m[FIT_PARAMS][FIT_PARAMS], d[FIT_PARAMS];
+            for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+                for (uint32_t q = 0; q < FIT_PARAMS; q++) m[p][q] = a[p][q];
+                m[p][p] += lambda * (a[p][p] > 0.0 ? a[p][p] : 1.0);
+                d[p] = -g[p];
+            }
+            if (solve(m, d)) {
+                for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+                    x_try[p] = x[p] + (d[p] > 3.0 ? 3.0 : d[p] < -3.0 ? -3.0 : d[p]); // At most e^3 per step
+                    if (x_try[p] < FIT_LOG_MIN) x_try[p] = FIT_LOG_MIN;
+                }
+                residuals(pb, x_try, r_try);
+                cost_try = sum_sq(r_try, pb->rows);
+                if (isfinite(cost_try) && cost_try < cost) { improved = true; break; }
+            }
+            lambda *= 4.0;
+        }
+        if (!improved) break;
+
+        double gain = (cost - cost_try) / cost;
+        memcpy(x, x_try, sizeof(x_try));
+        memcpy(r, r_try, pb->rows * sizeof(double));
+        cost = cost_try;
+        lambda = (lambda / 3.0 > 1e-12) ? lambda / 3.0 : 1e-12;
+        if (gain < 1e-10) break;
+    }
+    memcpy(res->x, x, sizeof(res->x));
+    res->cost = cost;
+    res->iterations = it;
+    free(r);
+    free(r_try);
+    free(jac);
+}
+
+// --- Starts ---
+
+static uint64_t rng_next(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+// Start k: k = 0 is the device's own model (where complete), the others are random
+static void start_point(const Chirp *c, uint32_t k, uint64_t seed, double *x) {
+    const double device[FIT_PARAMS] = { c->snapshot[0], c->snapshot[1], c->snapshot[2], c->snapshot[4],
+                                        c->snapshot[5], param_typical[5] };
+    uint64_t s = seed * 0x9E3779B97F4A7C15ULL + k + 1U;
+    for (int n = 0; n < 4; n++) rng_next(&s);
+    for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+        bool known = device[p] > 0.0;
+        double center = log(known ? device[p] : param_typical[p]);
+        double span = known ? log(10.0) : log(100.0);
+        double u = (double)(rng_next(&s) >> 11) / 9007199254740992.0; // [0, 1)
+        x[p] = (k == 0) ? center : center + span * (2.0 * u - 1.0);
+    }
+}
+
+// --- Main ---
+
+static void fit_file(const char *path, uint32_t starts, long workers, uint64_t seed) {
+    Chirp c;
+    StreamInfo info = { 0 };
+    uint32_t chirp_no = 0;
+    while (load_chirp(path, chirp_no, &c, &info)) {
+        Problem pb = { &c, 1.0 / info.adc_rate_hz, c.vel_rate ? info.adc_rate_hz / c.vel_rate : 1U, 0, 0, 0, NULL, NULL };
+        pb.i_sim = xcalloc(c.n, sizeof(double));
+        pb.w_sim = xcalloc(c.n, sizeof(double));
+
+        // Each channel weighs in by its own spread, whatever the sample counts
+        double si = 0.0, sw = 0.0;
+        uint32_t ni = 0, nw = 0;
+        for (uint32_t k = 0; k < c.n; k++) if (!isnan(c.i[k])) { si += c.i[k] * c.i[k]; ni++; }
+        for (uint32_t j = 1; j < c.vel_n; j++) if (!isnan(c.w[j])) { sw += c.w[j] * c.w[j]; nw++; }
+        if (ni < 100 || nw < 10 || si <= 0.0 || sw <= 0.0) {
+            fprintf(stderr, "%s: chirp %u has too few samples or no motion\n", path, chirp_no);
+            chirp_no++;
+            continue;
+        }
+        pb.scale_i = 1.0 / sqrt(si);
+        pb.scale_w = 1.0 / sqrt(sw);
+        pb.rows = ni + nw;
+
+        // --- Fan out: worker w takes starts w, w + workers, ... ---
+        long nw_proc = (workers > (long)starts) ? (long)starts : workers;
+        FILE **part = calloc((size_t)nw_proc, sizeof(FILE *));
+        pid_t *pid = calloc((size_t)nw_proc, sizeof(pid_t));
+        for (long w = 0; w < nw_proc; w++) {
+            part[w] = tmpfile();
+            if (!part[w]) { perror("tmpfile"); exit(1); }
+            pid[w] = fork();
+            if (pid[w] == 0) {
+                for (uint32_t k = (uint32_t)w; k < starts; k += (uint32_t)nw_proc) {
+                    double x[FIT_PARAMS];
+                    StartResult res = { .start = k };
+                    start_point(&c, k, seed, x);
+                    lm_fit(&pb, x, &res);
+                    fwrite(&res, sizeof(res), 1, part[w]);
+                }
+                fflush(part[w]);
+                _exit(0);
+            }
+            if (pid[w] < 0) { perror("fork"); exit(1); }
+        }
+
+        // --- Gather: best cost, and how many starts found it ---
+        StartResult best = { .cost = INFINITY };
+        StartResult *all = xcalloc(starts, sizeof(StartResult));
+        uint32_t done = 0;
+        for (long w = 0; w < nw_proc; w++) {
+            waitpid(pid[w], NULL, 0);
+            rewind(part[w]);
+            while (done < starts && fread(&all[done], sizeof(StartResult), 1, part[w]) == 1) {
+                if (all[done].cost < best.cost) best = all[done];
+                done++;
+            }
+            fclose(part[w]);
+        }
+        free(part);
+        free(pid);
+        uint32_t basin = 0;
+        for (uint32_t k = 0; k < done; k++) {
+            if (all[k].cost <= best.cost * (1.0 + FIT_BASIN_TOL)) basin++;
+        }
+        free(all);
+        if (!isfinite(best.cost)) {
+            fprintf(stderr, "%s: chirp %u: no start converged\n", path, chirp_no);
+            chirp_no++;
+            continue;
+        }
+
+        // --- Confidence intervals: reweight each channel by its residual RMS, cov = (J'J)^-1 ---
+        double *r = xcalloc(pb.rows, sizeof(double));
+        residuals(&pb, best.x, r);
+        double ri = sqrt(sum_sq(r, ni) / ni) / pb.scale_i;           // A
+        double rw = sqrt(sum_sq(r + ni, nw) / nw) / pb.scale_w;      // rad/s
+        pb.scale_i = 1.0 / ri;
+        pb.scale_w = 1.0 / rw;
+        double *jac = xcalloc((size_t)pb.rows * FIT_PARAMS, sizeof(double));
+        double a[FIT_PARAMS][FIT_PARAMS], g[FIT_PARAMS], ci[FIT_PARAMS];
+        residuals(&pb, best.x, r);
+        jacobian(&pb, best.x, r, jac);
+        normal_equations(jac, r, pb.rows, a, g);
+        for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+            double m[FIT_PARAMS][FIT_PARAMS], e[FIT_PARAMS] = { 0 };
+            memcpy(m, a, sizeof(m));
+            e[p] = 1.0;
+            // 95 % of a log-normal parameter, given as the half-width on the linear scale
+            ci[p] = solve(m, e) && e[p] > 0.0 ? exp(best.x[p]) * 1.96 * sqrt(e[p]) : INFINITY;
+        }
+        free(jac);
+        free(r);
+
+        // --- Report in firmware units ---
+        double fit[FIT_PARAMS];
+        for (uint32_t p = 0; p < FIT_PARAMS; p++) fit[p] = exp(best.x[p]);
+        const double device[FIT_PARAMS] = { c.snapshot[0], c.snapshot[1], c.snapshot[2], c.snapshot[4],
+                                            c.snapshot[5], NAN };
+        printf("%s chirp %u: %.2f V, %.2f .. %.1f Hz, %u current / %u velocity samples\n", path, chirp_no,
+               c.params[0], c.params[1], c.f_end_hz, ni, nw);
+        printf("%u starts on %ld workers, %u within %.0f %% of the best cost (%u iterations)\n", done,
+               nw_proc, basin, 100.0 * FIT_BASIN_TOL, best.iterations);
+        printf("residual rms: current %.4g A, velocity %.4g rad/s\n", ri, rw);
+        printf("%-9s %14s %12s %14s  %s\n", "global", "fit", "95 % +-", "device", "unit");
+        for (uint32_t p = 0; p < FIT_PARAMS; p++) {
+            if (isnan(device[p])) { // Not in the phase snapshot
+                printf("%-9s %14.6g %12.3g %14s  %s\n", param_name[p], fit[p], ci[p], "-", param_unit[p]);
+            } else {
+                printf("%-9s %14.6g %12.3g %14.6g  %s\n", param_name[p], fit[p], ci[p], device[p], param_unit[p]);
+            }
+            if (p == 2) {
+                printf("%-9s %14.6g %12.3g %14.6g  %s\n", "motor_Kt", fit[p], ci[p], (double)c.snapshot[3], "Nm/A");
+            }
+        }
+        printf("\n");
+        free(pb.i_sim);
+        free(pb.w_sim);
+        free(c.v);
+        free(c.i);
+        free(c.w);
+        chirp_no++;
+    }
+    if (chirp_no == 0) fprintf(stderr, "%s: no complete chirp phase\n", path);
+}
+
+int main(int argc, char **argv) {
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t starts = 32;
+    uint64_t seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:n:s:")) != -1) {
+        if (opt == 'j') workers = strtol(optarg, NULL, 10);
+        else if (opt == 'n') starts = (uint32_t)strtoul(optarg, NULL, 10);
+        else if (opt == 's') seed = strtoull(optarg, NULL, 10);
+        else {
+            fprintf(stderr, "usage: %s [-j workers] [-n starts] [-s seed] <file.dcmc>...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-j workers] [-n starts] [-s seed] <file.dcmc>...\n", argv[0]);
+        return 2;
+    }
+    if (workers < 1) workers = 1;
+    if (starts < 1) starts = 1;
+    fflush(stdout);
+    for (int k = optind; k < argc; k++) fit_file(argv[k], starts, workers, seed);
+    return 0;
+}
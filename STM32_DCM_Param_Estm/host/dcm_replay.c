@@ -0,0 +1,669 @@
+/*
+ * dcm_replay: re-runs the estimators over raw captures (motor_capture.h record format).
+ *
+ * Build (from STM32_DCM_Param_Estm/):
+ *   cc -O2 -std=gnu99 -DHOST_SIM -Ihost -I. -I../Common host/dcm_replay.c motor_params_rl.c \
+ *      motor_params_jb.c motor_lockin.c motor_adc.c motor_capture.c motor_params_mech.c \
+ *      motor_encoder.c motor_params_friction.c motor_current_loop.c motor_bridge.c \
+ *      ../Common/fxp_math.c -lm -o dcm_replay
+ *
+ * Usage:
+ *   dcm_replay [-j workers] <file.dcmc | directory>...
+ *
+ * Directories are searched recursively for *.dcmc. Files are split across worker
+ * processes (the estimator modules keep static state, so one process per core rather
+ * than threads). Output is CSV on stdout, one row per phase and algorithm, in file order:
+ *   file,phase_no,phase,algorithm,ok,v0,v1,v2,v3,device_v0
+ * and a per-algorithm fleet summary of v0 on stderr.
+ *
+ * "fw" rows run the firmware code: the current samples are replayed through the
+ * HOST_SIM ADC stream into estm_Ls(), estm_Ls_sine(), estm_Ls_lockin() and
+ * estm_RL_spectrum(), J/B/Tc go through mech_fit_*() and the friction sweep through
+ * friction_fit(). R, Ke and B go through the firmware's last step (estm_R_from_steady(),
+ * estm_Ke_from_steady(), estm_steady_torque()) on the recorded steady values, with each
+ * file's re-analyzed R and Kt carried forward. Other rows are alternative algorithms for comparison.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "motor_params_rl.h"
+#include "motor_params_jb.h"
+#include "motor_params_mech.h"
+#include "motor_params_friction.h"
+#include "motor_lockin.h"
+#include "motor_capture.h"
+
+// --- Host Stand-ins for Firmware Globals and HAL ---
+static TIM_TypeDef tim1_regs = { .ARR = 4199 };
+TIM_HandleTypeDef htim1 = { .Instance = &tim1_regs };
+ADC_HandleTypeDef hadc1;
+static uint32_t host_tick = 0;
+
+uint32_t HAL_GetTick(void) {
+    return host_tick++; // Advances so any wait loop terminates
+}
+
+void HAL_Delay(uint32_t ms) {
+    host_tick += ms;
+}
+
+// --- Capture Contents ---
+typedef struct {
+    uint16_t adc_resolution;
+    float v_ref;
+    float shunt;
+    float v_supply;
+    uint32_t adc_rate_hz;
+    uint32_t pwm_arr;
+    uint16_t adc_offset;  // Zero-current raw value (0 before version 2: unipolar sense)
+} StreamInfo;
+
+typedef struct {
+    uint8_t id;
+    float params[4];
+    float snapshot[6];    // R, L, Ke, Kt, J, B when the phase began
+    float results[4];     // As reported by the device
+    bool ended;
+    bool ok;
+    uint32_t dropped;
+    uint32_t begin_index;
+    bool have_zero;
+    uint32_t zero;        // First flush: excitation applied
+    // Current samples (absolute index, raw), in arrival order
+    uint32_t *cur_index;
+    uint16_t *cur_raw;
+    uint32_t cur_n, cur_cap;
+    // Dense current from zero on, built for replay
+    uint16_t *dense;
+    uint32_t dense_n;
+    float last_voltage;
+    // Velocity samples in the phase's own time base
+    float *vel;
+    uint32_t vel_n, vel_cap;
+    uint32_t vel_rate;
+    // Steady-state points (friction sweep)
+    float *pt_w, *pt_i;
+    uint32_t pt_n, pt_cap;
+} Phase;
+
+typedef struct {
+    StreamInfo info;
+    Phase *phase;
+    uint32_t phase_n, phase_cap;
+} Capture;
+
+static const char *phase_name(uint8_t id) {
+    static const char *names[] = { "?", "R", "L_STEP", "L_SINE", "L_LOCKIN", "RL_SPECTRUM", "KE", "B", "J",
+                                   "FRICTION", "CHIRP" };
+    return (id < sizeof(names) / sizeof(names[0])) ? names[id] : "?";
+}
+
+// --- Parsing ---
+
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static float get_f32(const uint8_t *p) { uint32_t u = get_u32(p); float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+static void *grow(void *ptr, uint32_t *cap, uint32_t need, size_t elem) {
+    if (need <= *cap) return ptr;
+    uint32_t n = *cap ? *cap : 256;
+    while (n < need) n *= 2;
+    void *p = realloc(ptr, (size_t)n * elem);
+    if (!p) { perror("realloc"); exit(1); }
+    *cap = n;
+    return p;
+}
+
+static bool parse_capture(const uint8_t *buf, size_t size, Capture *cap) {
+    size_t pos = 0;
+    Phase *cur = NULL;
+    bool have_stream = false;
+    memset(cap, 0, sizeof(*cap));
+
+    while (pos + 4 <= size) {
+        uint8_t type = buf[pos];
+        uint8_t tag = buf[pos + 1];
+        uint16_t len = get_u16(&buf[pos + 2]);
+        const uint8_t *p = &buf[pos + 4];
+        if (pos + 4 + len > size) break; // Truncated tail
+        pos += 4U + len;
+
+        switch (type) {
+        case CAP_REC_STREAM:
+            if (len < 28 || get_u32(p) != CAPTURE_MAGIC) return false;
+            cap->info.adc_resolution = get_u16(p + 6);
+            cap->info.v_ref = get_f32(p + 8);
+            cap->info.shunt = get_f32(p + 12);
+            cap->info.v_supply = get_f32(p + 16);
+            cap->info.adc_rate_hz = get_u32(p + 20);
+            cap->info.pwm_arr = get_u32(p + 24);
+            cap->info.adc_offset = (len >= 30) ? get_u16(p + 28) : 0U;
+            have_stream = true;
+            break;
+        case CAP_REC_PHASE_BEGIN:
+            if (len < 48) break;
+            cap->phase = grow(cap->phase, &cap->phase_cap, cap->phase_n + 1, sizeof(Phase));
+            cur = &cap->phase[cap->phase_n++];
+            memset(cur, 0, sizeof(*cur));
+            cur->id = tag;
+            cur->begin_index = get_u32(p + 4);
+            for (int i = 0; i < 4; i++) cur->params[i] = get_f32(p + 8 + 4 * i);
+            for (int i = 0; i < 6; i++) cur->snapshot[i] = get_f32(p + 24 + 4 * i);
+            break;
+        case CAP_REC_FLUSH:
+            if (cur && !cur->have_zero && len >= 4) {
+                cur->zero = get_u32(p);
+                cur->have_zero = true;
+            }
+            break;
+        case CAP_REC_CURRENT:
+            if (cur && len >= 4) {
+                uint32_t n = (len - 4U) / 2U;
+                uint32_t index = get_u32(p);
+                uint32_t need = cur->cur_n + n;
+                uint32_t c = cur->cur_cap;
+                cur->cur_index = grow(cur->cur_index, &c, need, sizeof(uint32_t));
+                cur->cur_raw = grow(cur->cur_raw, &cur->cur_cap, need, sizeof(uint16_t));
+                for (uint32_t i = 0; i < n; i++) {
+                    cur->cur_index[cur->cur_n] = index + i;
+                    cur->cur_raw[cur->cur_n++] = get_u16(p + 4 + 2 * i);
+                }
+            }
+            break;
+        case CAP_REC_VOLTAGE:
+            if (cur && len >= 8) cur->last_voltage = get_f32(p + 4);
+            break;
+        case CAP_REC_VELOCITY:
+            if (cur && len >= 8) {
+                uint32_t first = get_u32(p);
+                uint32_t n = (len - 8U) / 4U;
+                cur->vel_rate = get_u32(p + 4);
+                cur->vel = grow(cur->vel, &cur->vel_cap, first + n, sizeof(float));
+                for (uint32_t i = cur->vel_n; i < first; i++) cur->vel[i] = NAN; // Dropped records
+                for (uint32_t i = 0; i < n; i++) cur->vel[first + i] = get_f32(p + 8 + 4 * i);
+                if (first + n > cur->vel_n) cur->vel_n = first + n;
+            }
+            break;
+        case CAP_REC_POINT:
+            if (cur && len >= 8) {
+                uint32_t c = cur->pt_cap;
+                cur->pt_w = grow(cur->pt_w, &c, cur->pt_n + 1, sizeof(float));
+                cur->pt_i = grow(cur->pt_i, &cur->pt_cap, cur->pt_n + 1, sizeof(float));
+                cur->pt_w[cur->pt_n] = get_f32(p);
+                cur->pt_i[cur->pt_n++] = get_f32(p + 4);
+            }
+            break;
+        case CAP_REC_PHASE_END:
+            if (cur && cur->id == tag && len >= 28) {
+                cur->dropped = get_u32(p + 4);
+                cur->ok = get_u32(p + 8) != 0;
+                for (int i = 0; i < 4; i++) cur->results[i] = get_f32(p + 12 + 4 * i);
+                cur->ended = true;
+            }
+            cur = NULL;
+            break;
+        default:
+            break; // Unknown record: skip by length
+        }
+    }
+    return have_stream;
+}
+
+static void free_capture(Capture *cap) {
+    for (uint32_t i = 0; i < cap->phase_n; i++) {
+        free(cap->phase[i].cur_index);
+        free(cap->phase[i].cur_raw);
+        free(cap->phase[i].dense);
+        free(cap->phase[i].vel);
+        free(cap->phase[i].pt_w);
+        free(cap->phase[i].pt_i);
+    }
+    free(cap->phase);
+}
+
+// Samples from the excitation instant on, holes filled with the previous sample
+static void build_dense(Phase *ph) {
+    uint32_t zero = ph->have_zero ? ph->zero : ph->begin_index;
+    uint32_t hi = zero;
+    for (uint32_t i = 0; i < ph->cur_n; i++) {
+        if (ph->cur_index[i] >= hi) hi = ph->cur_index[i] + 1;
+    }
+    ph->dense_n = hi - zero;
+    ph->dense = calloc(ph->dense_n ? ph->dense_n : 1, sizeof(uint16_t));
+    uint8_t *have = calloc(ph->dense_n ? ph->dense_n : 1, 1);
+    for (uint32_t i = 0; i < ph->cur_n; i++) {
+        if (ph->cur_index[i] < zero) continue;
+        ph->dense[ph->cur_index[i] - zero] = ph->cur_raw[i];
+        have[ph->cur_index[i] - zero] = 1;
+    }
+    for (uint32_t i = 1; i < ph->dense_n; i++) {
+        if (!have[i]) ph->dense[i] = ph->dense[i - 1];
+    }
+    free(have);
+}
+
+// --- Replay Through the Firmware Code ---
+typedef struct {
+    const Phase *ph;
+    const StreamInfo *info;
+} ReplayCtx;
+
+static float raw_to_amps(const StreamInfo *info, uint16_t raw) {
+    return ((float)raw - info->adc_offset) / info->adc_resolution * info->v_ref / info->shunt;
+}
+
+static float replay_current(uint32_t index, void *ctx) {
+    const ReplayCtx *r = ctx;
+    if (r->ph->dense_n == 0) return 0.0f;
+    if (index >= r->ph->dense_n) index = r->ph->dense_n - 1; // Hold the last captured sample
+    return raw_to_amps(r->info, r->ph->dense[index]);
+}
+
+static void replay_begin(ReplayCtx *r) {
+    tim1_regs.ARR = r->info->pwm_arr;
+    adc_stream_start();
+    adc_sim_set_waveform(replay_current, r);
+}
+
+// --- Output ---
+typedef struct {
+    FILE *out;
+    const char *file;
+    uint32_t index;
+} Emit;
+
+static void row(const Emit *e, uint32_t phase_no, const Phase *ph, const char *algo, bool ok,
+                float v0, float v1, float v2, float v3) {
+    fprintf(e->out, "%u\t%s,%u,%s,%s,%d,%.7g,%.7g,%.7g,%.7g,%.7g\n", e->index, e->file, phase_no,
+            phase_name(ph->id), algo, ok ? 1 : 0, v0, v1, v2, v3, ph->results[0]);
+}
+
+static int cmp_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Mean and median current of the last n captured samples
+static bool tail_current(const Capture *cap, const Phase *ph, uint32_t n, float *mean, float *median) {
+    if (ph->cur_n == 0) return false;
+    if (n > ph->cur_n) n = ph->cur_n;
+    float *v = malloc(n * sizeof(float));
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        v[i] = raw_to_amps(&cap->info, ph->cur_raw[ph->cur_n - n + i]);
+        sum += v[i];
+    }
+    qsort(v, n, sizeof(float), cmp_float);
+    *mean = (float)(sum / n);
+    *median = (n & 1) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+    free(v);
+    return true;
+}
+
+static float tail_velocity(const Phase *ph, uint32_t n) {
+    double sum = 0.0;
+    uint32_t used = 0;
+    for (uint32_t i = (ph->vel_n > n) ? ph->vel_n - n : 0; i < ph->vel_n; i++) {
+        if (isnan(ph->vel[i])) continue;
+        sum += ph->vel[i];
+        used++;
+    }
+    return used ? (float)(sum / used) : 0.0f;
+}
+
+// Double precision lock-in with exact sin/cos, same window and delay as lockin_poll()
+static bool lockin_exact(const Capture *cap, const Phase *ph, float *L, float *z_re, float *z_im) {
+    float amp = ph->params[0], f_req = ph->params[1];
+    uint32_t cycles = (uint32_t)ph->params[2];
+    double fs = cap->info.adc_rate_hz;
+    uint32_t step = (uint32_t)(f_req / fs * 4294967296.0 + 0.5);
+    if (step == 0) return false;
+    double f = step * fs / 4294967296.0;
+    uint32_t per_cycle = (uint32_t)(4294967296.0 / step + 0.5);
+    uint32_t settle = LOCKIN_SETTLE_CYCLES * per_cycle;
+    uint32_t n = (uint32_t)(((uint64_t)cycles << 32) / step);
+    if (settle + n > ph->dense_n) return false;
+
+    double s = 0.0, c = 0.0;
+    for (uint32_t k = settle; k < settle + n; k++) {
+        double i = raw_to_amps(&cap->info, ph->dense[k]);
+        double th = 2.0 * M_PI * f * k / fs;
+        s += i * sin(th);
+        c += i * cos(th);
+    }
+    double i_s = 2.0 * s / n, i_c = 2.0 * c / n;
+    double d = 2.0 * M_PI * LOCKIN_DELAY_SAMPLES * f / fs;
+    double i_re = i_s * cos(d) - i_c * sin(d);
+    double i_im = i_s * sin(d) + i_c * cos(d);
+    double m2 = i_re * i_re + i_im * i_im;
+    if (m2 < 1e-12) return false;
+    double v = (double)(uint32_t)(amp / cap->info.v_supply * cap->info.pwm_arr + 0.5f) / cap->info.pwm_arr * cap->info.v_supply;
+    *z_re = (float)(v * i_re / m2);
+    *z_im = (float)(-v * i_im / m2);
+    *L = (float)(*z_im / (2.0 * M_PI * f));
+    return *z_im > 0.0f;
+}
+
+// Log-linear least-squares fit of the step response i = I_inf * (1 - exp(-t/tau)) up to 90 %
+static bool l_step_fit(const Capture *cap, const Phase *ph, float R, float *L) {
+    float V = ph->params[0];
+    if (R <= 0.0f) return false;
+    double i_inf = V / R, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < ph->dense_n; k++) {
+        double i = raw_to_amps(&cap->info, ph->dense[k]);
+        if (i >= 0.9 * i_inf) break;
+        double t = (k + 1) / (double)cap->info.adc_rate_hz; // Sample k is k+1 periods after the step
+        double y = log(1.0 - i / i_inf);
+        sx += t; sy += y; sxx += t * t; sxy += t * y; n++;
+    }
+    double det = n * sxx - sx * sx;
+    if (n < 3 || det <= 0.0) return false;
+    double slope = (n * sxy - sx * sy) / det; // -1/tau
+    if (slope >= 0.0) return false;
+    *L = (float)(R * -1.0 / slope);
+    return true;
+}
+
+static void analyze(const Capture *cap, const Emit *e) {
+    float R = 0.0f, Kt = 0.0f, B = 0.0f; // Re-analyzed values carried to later phases
+
+    for (uint32_t n = 0; n < cap->phase_n; n++) {
+        Phase *ph = &cap->phase[n];
+        ReplayCtx ctx = { ph, &cap->info };
+        float mean, median;
+        if (!ph->ended) continue; // Cut off by the end of the recording
+        build_dense(ph);
+        if (R <= 0.0f) R = ph->snapshot[0];
+        if (Kt <= 0.0f) Kt = ph->snapshot[3];
+        if (B <= 0.0f) B = ph->snapshot[5];
+
+        switch (ph->id) {
+        case CAP_PHASE_R:
+            // Same 100 ms average as estm_Rs(), over the last samples the device read
+            if (tail_current(cap, ph, 100U * cap->info.adc_rate_hz / 1000U, &mean, &median)) {
+                bool ok = estm_R_from_steady(ph->params[0], mean);
+                row(e, n, ph, "fw", ok, motor_R, mean, 0, 0);
+                row(e, n, ph, "median", median > 0.01f, median > 0.01f ? ph->params[0] / median : 0.0f, median, 0, 0);
+                if (ok) R = motor_R;
+            }
+            break;
+
+        case CAP_PHASE_L_STEP: {
+            float L = 0.0f;
+            replay_begin(&ctx);
+            motor_R = ph->params[1];
+            estm_Ls(ph->params[0]);
+            row(e, n, ph, "fw", motor_L > 0.0f, motor_L, 0, 0, 0);
+            bool ok = l_step_fit(cap, ph, ph->params[1], &L);
+            row(e, n, ph, "logfit", ok, L, 0, 0, 0);
+            break;
+        }
+
+        case CAP_PHASE_L_SINE:
+            replay_begin(&ctx);
+            motor_R = ph->params[2];
+            estm_Ls_sine(ph->params[0], ph->params[1]);
+            row(e, n, ph, "fw", motor_L > 0.0f, motor_L, 0, 0, 0);
+            break;
+
+        case CAP_PHASE_L_LOCKIN: {
+            float L = 0.0f, zr = 0.0f, zi = 0.0f;
+            replay_begin(&ctx);
+            estm_Ls_lockin(ph->params[0], ph->params[1], (uint32_t)ph->params[2]);
+            row(e, n, ph, "fw", motor_L > 0.0f, motor_L, 0, 0, 0);
+            bool ok = lockin_exact(cap, ph, &L, &zr, &zi);
+            row(e, n, ph, "exact", ok, L, zr, zi, 0);
+            break;
+        }
+
+        case CAP_PHASE_RL_SPECTRUM:
+            replay_begin(&ctx);
+            motor_R = 0.0f;
+            motor_L = 0.0f;
+            estm_RL_spectrum(ph->params[0], ph->params[1], ph->params[2]);
+            row(e, n, ph, "fw", motor_L > 0.0f, motor_R, motor_L, 0, 0);
+            break;
+
+        case CAP_PHASE_KE: {
+            // Recorded steady values (V, I, w) with this file's re-analyzed R
+            float V = ph->results[1], I = ph->results[2], w = ph->results[3];
+            motor_R = R;
+            bool ok = estm_Ke_from_steady(V, I, w);
+            row(e, n, ph, "fw", ok, motor_Ke, V, I, w);
+            if (ok) Kt = motor_Kt;
+            if (ph->vel_n > 1 && tail_current(cap, ph, 1000, &mean, &median)) {
+                float w_tail = tail_velocity(ph, 50);
+                bool ok2 = fabsf(w_tail) > 0.01f;
+                row(e, n, ph, "median", ok2, ok2 ? fabsf((V - median * R) / w_tail) : 0.0f, V, median, w_tail);
+            }
+            break;
+        }
+
+        case CAP_PHASE_B: {
+            float I = ph->results[1], w = ph->results[2];
+            bool ok = fabsf(w) > 0.01f;
+            motor_Kt = Kt;
+            row(e, n, ph, "fw", ok, ok ? fabsf(estm_steady_torque(I) / w) : 0.0f, I, w, Kt);
+            break;
+        }
+
+        case CAP_PHASE_J: {
+            // mech_fit_*() on the captured step and coast-down with the re-analyzed Kt
+            uint32_t n_step = (uint32_t)ph->params[2];
+            float torque = Kt * ph->params[0];
+            MechFit fit;
+            MechFitResult res = { 0 };
+            bool ok = false;
+            if (ph->vel_n > n_step && ph->vel_rate > 0) {
+                float dt = 1.0f / (float)ph->vel_rate;
+                mech_fit_reset(&fit);
+                ok = mech_fit_add_segment(&fit, ph->vel, n_step, dt, torque);
+                mech_fit_add_segment(&fit, ph->vel + n_step, ph->vel_n - n_step, dt, 0.0f);
+                ok = ok && estm_J_from_fit(&fit, &res);
+            }
+            row(e, n, ph, "fw", ok, res.J, res.B, res.Tc, res.rms);
+            if (ok) B = res.B;
+
+            // Two-point method of the old estm_Jm(): 20 ms apart, known B
+            uint32_t k = (uint32_t)(0.02f * ph->vel_rate);
+            if (k > 0 && k < n_step) {
+                float acc = (ph->vel[k] - ph->vel[0]) / 0.02f;
+                float J2 = (fabsf(acc) > 0.01f) ? (torque - B * 0.5f * (ph->vel[k] + ph->vel[0])) / acc : 0.0f;
+                row(e, n, ph, "twopoint", J2 > 0.0f, J2, acc, 0, 0);
+            }
+            break;
+        }
+
+        case CAP_PHASE_FRICTION: {
+            // friction_fit() on the recorded steady points with the re-analyzed Kt
+            FrictionData data;
+            FrictionModel model = { 0 };
+            friction_data_reset(&data);
+            motor_Kt = Kt;
+            for (uint32_t k = 0; k < ph->pt_n; k++) {
+                float torque = estm_steady_torque(ph->pt_i[k]);
+                friction_data_add(&data, ph->pt_w[k], ph->pt_w[k] > 0.0f ? torque : -torque);
+            }
+            bool ok = friction_fit(&data, &model);
+            row(e, n, ph, "fw", ok, 0.5f * (model.Tc[0] + model.Tc[1]), 0.5f * (model.Ts[0] + model.Ts[1]),
+                model.ws, 0.5f * (model.B[0] + model.B[1]));
+            if (ok) B = 0.5f * (model.B[0] + model.B[1]);
+
+            // Coulomb + viscous line through both directions (no Stribeck term)
+            double sx = 0, sy = 0, sxx = 0, sxy = 0;
+            for (uint32_t k = 0; k < data.n; k++) {
+                double x = fabs(data.w[k]), y = fabs(data.torque[k]);
+                sx += x; sy += y; sxx += x * x; sxy += x * y;
+            }
+            double det = data.n * sxx - sx * sx;
+            bool ok2 = data.n >= 2 && det > 0.0;
+            float b2 = ok2 ? (float)((data.n * sxy - sx * sy) / det) : 0.0f;
+            float tc2 = ok2 ? (float)((sy - b2 * sx) / data.n) : 0.0f;
+            row(e, n, ph, "coulvisc", ok2, tc2, tc2, 0, b2);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+// --- File Discovery ---
+static char **files = NULL;
+static uint32_t file_n = 0, file_cap = 0;
+
+static int collect(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)ftw;
+    size_t len = strlen(path);
+    if (flag == FTW_F && len > 5 && strcmp(path + len - 5, ".dcmc") == 0) {
+        files = grow(files, &file_cap, file_n + 1, sizeof(char *));
+        files[file_n++] = strdup(path);
+    }
+    return 0;
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void process_file(uint32_t index, FILE *out) {
+    FILE *f = fopen(files[index], "rb");
+    if (!f) {
+        perror(files[index]);
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(size > 0 ? (size_t)size : 1);
+    size_t got = fread(buf, 1, (size_t)size, f);
+    fclose(f);
+
+    Capture cap;
+    if (parse_capture(buf, got, &cap)) {
+        Emit e = { out, files[index], index };
+        analyze(&cap, &e);
+    } else {
+        fprintf(stderr, "%s: not a capture stream\n", files[index]);
+    }
+    free_capture(&cap);
+    free(buf);
+}
+
+// --- Fleet Summary ---
+typedef struct {
+    char key[48];
+    double sum, sum2;
+    uint32_t n, failed;
+} Stat;
+
+static int cmp_line(const void *a, const void *b) {
+    unsigned long x = strtoul(*(char *const *)a, NULL, 10), y = strtoul(*(char *const *)b, NULL, 10);
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "j:")) != -1) {
+        if (opt == 'j') workers = strtol(optarg, NULL, 10);
+        else {
+            fprintf(stderr, "usage: %s [-j workers] <file.dcmc | directory>...\n", argv[0]);
+            return 2;
+        }
+    }
+    for (int i = optind; i < argc; i++) nftw(argv[i], collect, 16, FTW_PHYS);
+    if (file_n == 0) {
+        fprintf(stderr, "no .dcmc captures found\n");
+        return 1;
+    }
+    qsort(files, file_n, sizeof(char *), cmp_str);
+    if (workers < 1) workers = 1;
+    if ((uint32_t)workers > file_n) workers = (long)file_n;
+
+    // --- Fan out: worker w takes files w, w + workers, ... ---
+    FILE **part = calloc((size_t)workers, sizeof(FILE *));
+    pid_t *pid = calloc((size_t)workers, sizeof(pid_t));
+    for (long w = 0; w < workers; w++) {
+        part[w] = tmpfile();
+        if (!part[w]) { perror("tmpfile"); return 1; }
+        pid[w] = fork();
+        if (pid[w] == 0) {
+            for (uint32_t i = (uint32_t)w; i < file_n; i += (uint32_t)workers) process_file(i, part[w]);
+            fflush(part[w]);
+            _exit(0);
+        }
+        if (pid[w] < 0) { perror("fork"); return 1; }
+    }
+
+    // --- Gather in file order ---
+    char **lines = NULL;
+    uint32_t line_n = 0, line_cap = 0;
+    for (long w = 0; w < workers; w++) {
+        char *line = NULL;
+        size_t len = 0;
+        waitpid(pid[w], NULL, 0);
+        rewind(part[w]);
+        while (getline(&line, &len, part[w]) > 0) {
+            lines = grow(lines, &line_cap, line_n + 1, sizeof(char *));
+            lines[line_n++] = strdup(line);
+        }
+        free(line);
+        fclose(part[w]);
+    }
+    // Rows of one file come from one worker in order; a stable merge by file index keeps it
+    for (uint32_t i = 1; i < line_n; i++) {
+        char *l = lines[i];
+        uint32_t j = i;
+        while (j > 0 && cmp_line(&lines[j - 1], &l) > 0) { lines[j] = lines[j - 1]; j--; }
+        lines[j] = l;
+    }
+
+    Stat *stat = NULL;
+    uint32_t stat_n = 0, stat_cap = 0;
+    printf("file,phase_no,phase,algorithm,ok,v0,v1,v2,v3,device_v0\n");
+    for (uint32_t i = 0; i < line_n; i++) {
+        char *csv = strchr(lines[i], '\t') + 1;
+        fputs(csv, stdout);
+
+        // file,phase_no,phase,algorithm,ok,v0,...
+        char phase[16], algo[16];
+        int ok;
+        double v0;
+        const char *p = csv;
+        for (int c = 0; c < 2; c++) p = strchr(p, ',') + 1;
+        if (sscanf(p, "%15[^,],%15[^,],%d,%lf", phase, algo, &ok, &v0) != 4) continue;
+        char key[48];
+        snprintf(key, sizeof(key), "%s/%s", phase, algo);
+        uint32_t s = 0;
+        while (s < stat_n && strcmp(stat[s].key, key) != 0) s++;
+        if (s == stat_n) {
+            stat = grow(stat, &stat_cap, stat_n + 1, sizeof(Stat));
+            memset(&stat[s], 0, sizeof(Stat));
+            strcpy(stat[s].key, key);
+            stat_n++;
+        }
+        if (!ok) { stat[s].failed++; continue; }
+        stat[s].sum += v0;
+        stat[s].sum2 += v0 * v0;
+        stat[s].n++;
+    }
+
+    fprintf(stderr, "%u captures, %ld workers\n%-24s %6s %6s %14s %14s\n", file_n, workers,
+            "phase/algorithm", "ok", "failed", "mean(v0)", "std(v0)");
+    for (uint32_t s = 0; s < stat_n; s++) {
+        double mean = stat[s].n ? stat[s].sum / stat[s].n : 0.0;
+        double var = stat[s].n ? stat[s].sum2 / stat[s].n - mean * mean : 0.0;
+        fprintf(stderr, "%-24s %6u %6u %14.6g %14.6g\n", stat[s].key, stat[s].n, stat[s].failed,
+                mean, sqrt(var > 0.0 ? var : 0.0));
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef HOST_DEBUG_H_
+#define HOST_DEBUG_H_
+
+// Host stand-in for the RTT debug header: estimator chatter goes to stderr with
+// -DDEBUG_PRINT, otherwise it is dropped so replay output stays machine readable.
+// The dropped form still type-checks its arguments and counts as a use of them.
+
+#include <stdio.h>
+
+#ifdef DEBUG_PRINT
+#define DEBUG_INIT() ((void)0)
+#define DEBUG_PRINTF(...) fprintf(stderr, __VA_ARGS__)
+#else
+#define DEBUG_INIT() ((void)0)
+#define DEBUG_PRINTF(...) do { if (0) fprintf(stderr, __VA_ARGS__); } while (0)
+#endif
+
+#endif /* HOST_DEBUG_H_ */
@@ -0,0 +1,207 @@
+/*
+ * log_decode: rebuilds DEBUG_PRINTF text from the deferred binary log (motor_log.h record format).
+ *
+ * Build (from STM32_DCM_Param_Estm/):
+ *   cc -O2 -std=gnu99 -Ihost -I. host/log_decode.c -o log_decode
+ *
+ * Usage:
+ *   log_decode <firmware.elf> [log file | -]
+ *
+ * The ELF must be the image that produced the log: record headers are addresses in its
+ * .log_fmt section. %s arguments are looked up in the loaded sections, so literals print
+ * and strings in RAM show as their address. Reads stdin without a log file or with "-",
+ * e.g. piped from a live JLinkRTTLogger.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <elf.h>
+#include "motor_log.h"
+
+// --- Firmware Image ---
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    const char *data;
+} Section;
+
+static uint8_t *elf = NULL;
+static Section fmt_sec;
+static Section *loaded = NULL;   // SHF_ALLOC sections with file contents (%s lookup)
+static uint32_t loaded_n = 0;
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return NULL; }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(n > 0 ? (size_t)n : 1U);
+    if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) { perror(path); fclose(f); free(buf); return NULL; }
+    fclose(f);
+    *size = (size_t)n;
+    return buf;
+}
+
+static bool load_elf(const char *path) {
+    size_t size;
+    elf = read_file(path, &size);
+    if (!elf) return false;
+
+    const Elf32_Ehdr *eh = (const Elf32_Ehdr *)elf;
+    if (size < sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 ||
+        eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_ident[EI_DATA] != ELFDATA2LSB) {
+        fprintf(stderr, "%s: not a little-endian ELF32 image\n", path);
+        return false;
+    }
+    if (eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf32_Shdr) > size || eh->e_shstrndx >= eh->e_shnum) {
+        fprintf(stderr, "%s: truncated section table\n", path);
+        return false;
+    }
+    const Elf32_Shdr *sh = (const Elf32_Shdr *)(elf + eh->e_shoff);
+    const char *names = (const char *)elf + sh[eh->e_shstrndx].sh_offset;
+
+    loaded = calloc(eh->e_shnum, sizeof(Section));
+    for (uint32_t i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_type != SHT_PROGBITS || sh[i].sh_offset + (size_t)sh[i].sh_size > size) continue;
+        Section s = { sh[i].sh_addr, sh[i].sh_size, (const char *)elf + sh[i].sh_offset };
+        if (strcmp(names + sh[i].sh_name, ".log_fmt") == 0) fmt_sec = s;
+        else if (sh[i].sh_flags & SHF_ALLOC) loaded[loaded_n++] = s;
+    }
+    if (!fmt_sec.data) {
+        fprintf(stderr, "%s: no .log_fmt section (see motor_log.h for the linker script entry)\n", path);
+        return false;
+    }
+    return true;
+}
+
+// NUL-terminated string at a target address, NULL if it is not in the image
+static const char *lookup(const Section *s, uint32_t n, uint32_t addr) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (addr < s[i].addr || addr - s[i].addr >= s[i].size) continue;
+        const char *p = s[i].data + (addr - s[i].addr);
+        return memchr(p, '\0', s[i].size - (addr - s[i].addr)) ? p : NULL;
+    }
+    return NULL;
+}
+
+// --- Formatting ---
+
+static bool line_start = true;
+
+static void emit(const char *text, uint32_t tick_ms) {
+    for (; *text; text++) {
+        if (line_start) printf("%9.3f  ", tick_ms / 1000.0);
+        putchar(*text);
+        line_start = (*text == '\n');
+    }
+}
+
+// printf on the host with the target's argument words; one conversion at a time, since the
+// words are 32-bit and floats arrive as float bit patterns
+static void render(const char *fmt, uint32_t n, const uint32_t *args, uint32_t tick_ms) {
+    char out[1024], spec[32], piece[256];
+    size_t len = 0;
+    uint32_t a = 0;
+
+    while (*fmt && len < sizeof(out) - 1) {
+        if (*fmt != '%') { out[len++] = *fmt++; continue; }
+        if (fmt[1] == '%') { out[len++] = '%'; fmt += 2; continue; }
+
+        // %[flags][width][.precision][length]conversion; the length modifier is dropped
+        size_t k = 0;
+        spec[k++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.", *fmt) && k < sizeof(spec) - 3) spec[k++] = *fmt++;
+        while (*fmt && strchr("hlLqjzt", *fmt)) fmt++;
+        char conv = *fmt ? *fmt++ : '\0';
+        spec[k++] = conv;
+        spec[k] = '\0';
+
+        if (a >= n) {
+            snprintf(piece, sizeof(piece), "<?>");
+        } else {
+            uint32_t w = args[a++];
+            float f;
+            memcpy(&f, &w, sizeof(f));
+            switch (conv) {
+            case 'd': case 'i':
+                snprintf(piece, sizeof(piece), spec, (int)(int32_t)w);
+                break;
+            case 'u': case 'o': case 'x': case 'X': case 'c':
+                snprintf(piece, sizeof(piece), spec, (unsigned)w);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                snprintf(piece, sizeof(piece), spec, (double)f);
+                break;
+            case 's': {
+                const char *s = lookup(loaded, loaded_n, w);
+                if (s) snprintf(piece, sizeof(piece), spec, s);
+                else snprintf(piece, sizeof(piece), "<str@0x%08x>", (unsigned)w);
+                break;
+            }
+            default:
+                snprintf(piece, sizeof(piece), "0x%08x", (unsigned)w);
+                break;
+            }
+        }
+        size_t m = strlen(piece);
+        if (m > sizeof(out) - 1 - len) m = sizeof(out) - 1 - len;
+        memcpy(out + len, piece, m);
+        len += m;
+    }
+    out[len] = '\0';
+    emit(out, tick_ms);
+}
+
+// --- Main ---
+
+static bool read_words(FILE *f, uint32_t *w, uint32_t n) {
+    uint8_t b[4];
+    for (uint32_t i = 0; i < n; i++) {
+        if (fread(b, 1, 4, f) != 4) return false;
+        w[i] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <firmware.elf> [log file | -]\n", argv[0]);
+        return 2;
+    }
+    if (!load_elf(argv[1])) return 1;
+    FILE *in = (argc == 3 && strcmp(argv[2], "-") != 0) ? fopen(argv[2], "rb") : stdin;
+    if (!in) { perror(argv[2]); return 1; }
+
+    uint32_t head[2], args[LOG_MAX_ARGS];
+    uint32_t records = 0, unknown = 0;
+    while (read_words(in, head, 2)) {
+        uint32_t n = head[0] >> 24;
+        uint32_t addr = head[0] & LOG_ADDR_MASK;
+        if (n > LOG_MAX_ARGS || !read_words(in, args, n)) {
+            fprintf(stderr, "log_decode: bad or truncated record after %u records\n", records);
+            break;
+        }
+        records++;
+
+        if (addr == LOG_ADDR_DROPPED && n == 1) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "[log: %u records dropped]\n", args[0]);
+            if (!line_start) emit("\n", head[1]);
+            emit(msg, head[1]);
+            continue;
+        }
+        const char *fmt = lookup(&fmt_sec, 1, (fmt_sec.addr & ~LOG_ADDR_MASK) | addr);
+        if (!fmt) {
+            unknown++;
+            continue;
+        }
+        render(fmt, n, args, head[1]);
+    }
+    if (!line_start) putchar('\n');
+    if (unknown) fprintf(stderr, "log_decode: %u records with unknown format (ELF does not match?)\n", unknown);
+    return 0;
+}
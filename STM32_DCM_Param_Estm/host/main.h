@@ -0,0 +1,44 @@
+#ifndef HOST_MAIN_H_
+#define HOST_MAIN_H_
+
+// Host stand-in for the CubeMX main.h: just enough HAL for the estimator modules
+// to build with -DHOST_SIM (see dcm_replay.c)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+typedef struct {
+    uint32_t ARR;
+    uint32_t CCR1;
+    uint32_t CCR2;
+    uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    void *DMA_Handle;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    void *Instance;
+    void *DMA_Handle;
+} ADC_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x00U
+#define TIM_CHANNEL_2 0x04U
+#define TIM_CHANNEL_ALL 0x3CU
+
+#define __HAL_TIM_SET_COMPARE(h, ch, v) \
+    (*((ch) == TIM_CHANNEL_2 ? &(h)->Instance->CCR2 : &(h)->Instance->CCR1) = (v))
+#define __HAL_TIM_GET_COUNTER(h) ((h)->Instance->CNT)
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+
+#endif /* HOST_MAIN_H_ */
@@ -0,0 +1,148 @@
+/*
+ * mech_check: Monte-Carlo check of the J/B/Tc fit (motor_params_mech.h) against the old two-point J.
+ *
+ * Build (from STM32_DCM_Param_Estm/):
+ *   cc -O2 -std=gnu99 -DHOST_SIM -Ihost -I. host/mech_check.c motor_params_mech.c -lm -o mech_check
+ *
+ * Usage:
+ *   mech_check [runs] [sigma_w] [seed]
+ *
+ * Every run simulates the capture of estm_Jm() on a known motor (J=1e-4, B=2e-5, Tc=2e-3,
+ * Kt=0.05, 0.8 A step): MECH_STEP_MS of constant torque, then the free coast-down until the
+ * shaft stops or the MECH_CAPTURE_LEN buffer is full, sampled at MECH_CAPTURE_RATE_HZ with
+ * white velocity noise of sigma_w rad/s (default 0.3). Each run goes through mech_fit_*()
+ * and through the two-point formula of the old estm_Jm() (samples 20 ms apart, B known).
+ * Prints mean, bias and standard deviation of J for both and exits non-zero unless the fit
+ * has the lower J variance.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "motor_params_mech.h"
+
+// --- Simulated Motor ---
+#define SIM_J 1e-4
+#define SIM_B 2e-5
+#define SIM_TC 2e-3
+#define SIM_KT 0.05
+#define SIM_CURRENT 0.8     // Step current, as main.c estm_cfg.j_current (A)
+#define SIM_SUBSTEPS 20U    // Integration steps per velocity sample
+#define TWOPOINT_S 0.02     // Sample spacing of the old estm_Jm()
+
+// mech_capture_tick() is not exercised here; the samples come from the simulation
+float read_velo(void) {
+    return 0.0f;
+}
+
+// --- Noise ---
+static uint64_t rng_state;
+
+static double uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static double gaussian(void) {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+// Advances w by one sample period under torque, sticking once friction stops the shaft
+static double sim_sample(double w, double torque, double dt) {
+    double h = dt / SIM_SUBSTEPS;
+    for (uint32_t k = 0; k < SIM_SUBSTEPS; k++) {
+        if (w == 0.0 && fabs(torque) <= SIM_TC) continue; // Stuck
+        double s = (w != 0.0) ? copysign(1.0, w) : copysign(1.0, torque);
+        double w_next = w + h * (torque - SIM_B * w - SIM_TC * s) / SIM_J;
+        if (w != 0.0 && w_next * w < 0.0) w_next = 0.0;
+        w = w_next;
+    }
+    return w;
+}
+
+typedef struct {
+    double sum;
+    double sum_sq;
+    uint32_t n;
+} Stat;
+
+static void stat_add(Stat *st, double x) {
+    st->sum += x;
+    st->sum_sq += x * x;
+    st->n++;
+}
+
+static double stat_mean(const Stat *st) {
+    return st->n ? st->sum / st->n : NAN;
+}
+
+static double stat_var(const Stat *st) {
+    if (st->n < 2) return NAN;
+    double m = stat_mean(st);
+    return (st->sum_sq - st->n * m * m) / (st->n - 1);
+}
+
+static void report(const char *name, const Stat *st, uint32_t runs) {
+    double m = stat_mean(st);
+    printf("%-9s %5u/%-5u %12.5g %+9.2f %% %12.4g\n", name, st->n, runs, m,
+           100.0 * (m - SIM_J) / SIM_J, sqrt(stat_var(st)));
+}
+
+int main(int argc, char **argv) {
+    uint32_t runs = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 500U;
+    double sigma_w = (argc > 2) ? atof(argv[2]) : 0.3;
+    rng_state = (argc > 3) ? strtoull(argv[3], NULL, 0) : 1U;
+    if (runs < 2 || rng_state == 0) {
+        fprintf(stderr, "usage: %s [runs >= 2] [sigma_w] [seed != 0]\n", argv[0]);
+        return 2;
+    }
+
+    const double dt = MECH_CAPTURE_PERIOD_S;
+    const double torque = SIM_KT * SIM_CURRENT;
+    const uint32_t k2 = (uint32_t)(TWOPOINT_S / dt + 0.5);
+    static float w[MECH_CAPTURE_LEN];
+    Stat fit_J = { 0 }, two_J = { 0 };
+
+    for (uint32_t run = 0; run < runs; run++) {
+        // Step from rest, then coast down; sample k lands one period after the previous
+        double w_true = 0.0;
+        uint32_t n_step = MECH_STEP_SAMPLES, n = 0;
+        for (; n < n_step; n++) {
+            w_true = sim_sample(w_true, torque, dt);
+            w[n] = (float)(w_true + sigma_w * gaussian());
+        }
+        for (; n < MECH_CAPTURE_LEN; n++) {
+            w_true = sim_sample(w_true, 0.0, dt);
+            w[n] = (float)(w_true + sigma_w * gaussian());
+            if (fabsf(w[n]) < MECH_STOP_VELOCITY) {
+                n++;
+                break;
+            }
+        }
+
+        MechFit fit;
+        MechFitResult res;
+        mech_fit_reset(&fit);
+        bool ok = mech_fit_add_segment(&fit, w, n_step, (float)dt, (float)torque);
+        mech_fit_add_segment(&fit, w + n_step, n - n_step, (float)dt, 0.0f);
+        if (ok && mech_fit_solve(&fit, &res)) stat_add(&fit_J, res.J);
+
+        // Old estm_Jm(): (T - B * mean w) / (dw / dt), Coulomb friction ignored
+        double acc = (w[k2] - w[0]) / TWOPOINT_S;
+        if (fabs(acc) > 0.01) stat_add(&two_J, (torque - SIM_B * 0.5 * (w[k2] + w[0])) / acc);
+    }
+
+    printf("J = %g kg*m^2, %u runs, sigma_w = %g rad/s\n", SIM_J, runs, sigma_w);
+    printf("%-9s %11s %12s %11s %12s\n", "method", "ok", "mean J", "bias", "std J");
+    report("fit", &fit_J, runs);
+    report("twopoint", &two_J, runs);
+    double ratio = stat_var(&two_J) / stat_var(&fit_J);
+    printf("variance ratio twopoint / fit: %.1f\n", ratio);
+
+    bool pass = fit_J.n == runs && ratio > 1.0;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
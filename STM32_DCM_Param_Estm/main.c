@@ -1,23 +1,65 @@
 #include "main.h"
 #include "motor_params_rl.h" // Include the RL estimation module header
 #include "motor_params_jb.h" // Include the JB estimation module header
-#include "debug.h"            // Include the debug print header
+#include "motor_adc.h"        // Timer-triggered DMA current sampling
+#include "motor_lockin.h"     // Lock-in excitation generator
+#include "motor_params_rls.h" // Online parameter tracking
+#include "motor_estm_seq.h"   // Non-blocking estimation sequence
+#include "motor_params_mech.h" // High-rate velocity capture
+#include "motor_encoder.h"     // Encoder velocity (M/T, PLL)
+#include "motor_capture.h"     // Raw sample capture for host re-analysis
+#include "motor_params_store.h" // Parameters kept in flash across resets
+#include "motor_params_friction.h" // Friction map for compensation
+#include "motor_current_loop.h"  // PI current control at PWM rate
+#include "motor_bridge.h"       // Bipolar H-bridge output
+#include "motor_log.h"        // DEBUG_PRINTF (deferred binary log over RTT)
+#include "rt_exec.h"          // Run-to-completion task executive (Common/)
 
 // --- Peripheral Handles (Define them here or ensure they are defined in main.h/elsewhere) ---
 TIM_HandleTypeDef htim1; // Example: Assuming TIM1 is used for PWM
 ADC_HandleTypeDef hadc1; // Example: Assuming ADC1 is used for current
+TIM_HandleTypeDef htim2; // Encoder mode counter
+TIM_HandleTypeDef htim5; // 32-bit encoder edge timestamps
 
 // --- Private function prototypes ---
 static void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_ADC1_Init(void);
 static void MX_TIM1_Init(void);
+static void MX_TIM2_Init(void);
+static void MX_TIM5_Init(void);
+static bool reestimate_requested(void);
+static void print_params(const char *title);
+static void start_online_tracking(void);
+static void estimation_task(void *ctx);
+static void param_store_task(void *ctx);
+static bool motor_idle(void);
+static void monitor_task(void *ctx);
+static uint32_t exec_clock(void);
+
+// --- Executive Tasks ---
+// One tick per ms from SysTick; table order is priority. Budgets are the worst cases the
+// schedule is checked against (host: Common/host/exec_sim); the flash sector erase when the
+// parameter store wraps (~1 s, rare, only with the motor idle) overruns param_store by design
+// and shows up as such.
+#define EXEC_TICK_US 1000U
+static ExecTask tasks[] = {
+  { .name = "estimation", .fn = estimation_task, .period = ESTM_SEQ_TICK_MS, .budget_us = 300 }, // Fits sliced per tick (motor_estm_seq.h)
+  { .name = "param_store", .fn = param_store_task, .period = 1000, .budget_us = 600 },
+  { .name = "monitor", .fn = monitor_task, .period = 1000, .offset = 500, .budget_us = 200 },
+};
+static bool online_running = false;
+static uint32_t last_save = 0;
+static bool save_pending = false; // Written by param_store_task once the motor is idle
 
 int main(void) {
 
   // --- MCU Configuration ---
   HAL_Init();
   SystemClock_Config();
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // DWT cycle counter: task execution times
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
   // --- Initialize RTT (conditionally via macro) ---
   DEBUG_INIT();
@@ -27,65 +69,169 @@ int main(void) {
   MX_GPIO_Init();
   MX_ADC1_Init(); // Initialize ADC used for current sensing
   MX_TIM1_Init(); // Initialize Timer used for PWM
+  MX_TIM2_Init(); // Initialize encoder counter
+  MX_TIM5_Init(); // Initialize encoder edge capture
 
   DEBUG_PRINTF("\n\n--- DC Motor Parameter Estimation ---\n");
 
   // --- Start necessary peripherals ---
-  HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1); // Start PWM output
+  bridge_start(); // Both H-bridge legs at 50 % (0 V)
+#ifdef CAPTURE_RAW
+  capture_start(); // Raw samples of every estimation phase on RTT channel CAPTURE_RTT_CHANNEL (header needs TIM1 ARR)
+#endif
+  HAL_TIM_Base_Start_IT(&htim1); // Update interrupt drives table-based excitation
   // Calibrate ADC if necessary
   // HAL_ADCEx_Calibration_Start(&hadc1);
+  adc_stream_start(); // Current samples at PWM rate from here on, consumed by all estimators
+  HAL_ADCEx_InjectedStart_IT(&hadc1); // Same trigger, one current loop update per PWM period
+  encoder_init(ENC_PLL_BANDWIDTH_HZ); // Velocity updates at ENC_UPDATE_RATE_HZ from here on
+  // encoder_set_mode(ENC_MODE_PLL); // Smoother velocity for control, at the cost of some lag
 
 
   // --- Parameter Estimation Sequence ---
+  // Runs as a state machine from the main loop: each step ends when its measurement
+  // settles instead of after a fixed delay, and nothing else is blocked meanwhile.
+  // Choose the inductance method in the sequencer (lock-in); the blocking variants
+  // estm_Ls(), estm_Ls_sine(), estm_RL_spectrum() and estm_Ke_Kt()/estm_Bm()/estm_Jm()
+  // remain available for one-off measurements.
+  EstmSeqConfig estm_cfg = {
+    .r_voltage = 2.0f,          // R with 2V (adjust voltage as needed)
+    .l_amplitude = 3.0f,        // Lock-in L: 3V amplitude,
+    .l_frequency_hz = 100.0f,   //   100 Hz,
+    .l_cycles = 4,              //   4 cycles
+    .ke_velocity = 15.0f,       // rad/s (approx 143 RPM)
+    .f_min_velocity = 0.5f,     // Friction sweep: 0.5 rad/s, where Coulomb/Stribeck dominate,
+    .f_max_velocity = 30.0f,    //   up to 30 rad/s (approx 286 RPM) for the viscous slope,
+    .f_points = 10,             //   10 speeds per direction
+    .j_current = 0.8f,          // Amps - Choose a value that gives reasonable acceleration
+    .chirp_amplitude = 3.0f,    // Chirp for host/dcm_fit (CAPTURE_RAW only): 3V,
+    .chirp_f_start_hz = 0.5f,   //   0.5 Hz, below the mechanical corner,
+    .chirp_f_end_hz = 500.0f,   //   up to 500 Hz, past the electrical one,
+    .chirp_duration_s = 4.0f,   //   in 4 s
+    .operator_wait_ms = 5000,   // Time to lock / unlock the shaft
+  };
+
+  // --- Fast Path ---
+  // A valid record from an earlier run replaces the whole sequence (20+ s with the shaft
+  // lock/unlock waits); it is re-run on a new board, other hardware scaling, or on request.
+  if (reestimate_requested()) param_store_invalidate();
+  ParamStoreStatus stored = param_store_load();
+  if (stored == PARAM_STORE_OK) {
+    print_params("Loaded From Flash");
+    start_online_tracking();
+  } else {
+    DEBUG_PRINTF("No usable stored parameters (%s), estimating.\n",
+                 stored == PARAM_STORE_EMPTY ? "empty" :
+                 stored == PARAM_STORE_INVALIDATED ? "invalidated" : "stale");
+    estm_seq_start(&estm_cfg);
+  }
+  last_save = HAL_GetTick();
+
+  // --- Main loop ---
+  // Everything periodic runs as an executive task from here on (see Executive Tasks)
+  exec_init(tasks, sizeof(tasks) / sizeof(tasks[0]), exec_clock, SystemCoreClock / 1000000U);
+  if (!exec_schedulable(tasks, sizeof(tasks) / sizeof(tasks[0]), EXEC_TICK_US, NULL)) {
+    DEBUG_PRINTF("Task budgets do not fit their periods.\n");
+  }
+  while (1)
+  {
+    exec_run(); // __WFI() when it returns false would sleep until the next tick
+  }
+}
+
+// --- Executive Tasks ---
+
+static void start_online_tracking(void) {
+  float amps, volts;
+  online_estm_init(0.999f); // ~1 s memory at 1 ms updates
+  current_loop_take_means(&amps, &volts); // Drop the samples accumulated before tracking starts
+  online_running = true;
+}
+
+static void estimation_task(void *ctx) {
+  (void)ctx;
+  if (estm_seq_busy()) {
+    if (estm_seq_tick() != SEQ_DONE) return;
+
+    DC_Ctl_Velo(0.0f); // Stop the motor after estimation for safety (once, it holds)
+    print_params("Estimation Complete");
+    save_pending = true; // As soon as the shaft has coasted to rest
+    last_save = HAL_GetTick();
 
-  // ** R and L Estimation (Requires SHAFT LOCKED) **
-  DEBUG_PRINTF("\n*** PHASE 1: R/L Estimation (LOCK MOTOR SHAFT!) ***\n");
-  HAL_Delay(5000); // Give user time to lock the shaft
+    // --- Online tracking ---
+    // Parameters keep following temperature drift while the machine runs production moves
+    start_online_tracking();
+    return;
+  }
 
-  estm_Rs(2.0f); // Estimate R with 2V (adjust voltage as needed)
-  HAL_Delay(1000);
-  // Choose one inductance estimation method:
-  // estm_Ls(5.0f); // Step method
-  estm_Ls_sine(3.0f, 100.0f); // Sine method (Example: 3V amplitude, 100 Hz)
-  HAL_Delay(1000);
+  // One online estimator update per control cycle (ONLINE_ESTM_TS), on the means of the
+  // PWM periods of this tick that the injected ADC interrupt kept: nothing here waits for samples
+  float amps, volts;
+  if (online_running && current_loop_take_means(&amps, &volts)) {
+    online_estm_update(volts, amps, read_velo());
+  }
+}
 
-  // ** Ke, B, J Estimation (Requires SHAFT UNLOCKED) **
-  DEBUG_PRINTF("\n*** PHASE 2: Ke/B/J Estimation (UNLOCK MOTOR SHAFT!) ***\n");
-  HAL_Delay(5000); // Give user time to unlock the shaft
+static void param_store_task(void *ctx) {
+  (void)ctx;
+  // Write back tracked drift, rate limited so the flash sector lasts
+  if (online_running && !save_pending && HAL_GetTick() - last_save >= PARAM_STORE_SAVE_INTERVAL_MS) {
+    last_save = HAL_GetTick();
+    save_pending = param_store_drifted(PARAM_STORE_DRIFT_TOL);
+  }
+  // Programming, and the sector erase when the store wraps (1-2 s), stall code fetch from
+  // flash: deferred until the motor is idle, however long that takes
+  if (save_pending && motor_idle()) {
+    save_pending = false;
+    if (!param_store_save()) DEBUG_PRINTF("Parameter store write failed.\n");
+  }
+}
 
-  // Define test parameters (adjust based on your motor and setup)
-  float test_vel_for_Ke = 15.0f; // rad/s (approx 143 RPM)
-  float test_vel_for_B = 10.0f;  // rad/s (approx 95 RPM) - Use a different speed than Ke
-  float test_current_for_J = 0.8f; // Amps - Choose a value that gives reasonable acceleration
+// Nothing to control: current loop off, bridge at 0 V and the shaft at rest
+static bool motor_idle(void) {
+  float w = read_velo();
+  return !current_loop_enabled() && bridge_output() == 0 && w > -STOP_VELOCITY && w < STOP_VELOCITY;
+}
 
-  estm_Ke_Kt(test_vel_for_Ke);
-  HAL_Delay(1000);
+static void monitor_task(void *ctx) {
+  (void)ctx;
+  if (!exec_overrun()) return;
+  for (uint8_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+    DEBUG_PRINTF("Task %s: max %lu us (budget %lu), %lu overruns, %lu missed\n", tasks[i].name,
+                 exec_task_max_us(&tasks[i]), tasks[i].budget_us, tasks[i].overruns, tasks[i].misses);
+  }
+  exec_clear_flags();
+}
 
-  estm_B(test_vel_for_B);
-  HAL_Delay(1000);
+static uint32_t exec_clock(void) {
+  return DWT->CYCCNT;
+}
 
-  estm_J(test_current_for_J);
-  HAL_Delay(1000);
+// SysTick_Handler calls HAL_IncTick() then HAL_SYSTICK_IRQHandler(), which lands here
+void HAL_SYSTICK_Callback(void) {
+  exec_tick();
+}
 
+static void print_params(const char *title) {
   // --- Print Final Results --- (Using DEBUG_PRINTF macro)
-  DEBUG_PRINTF("\n--- Estimation Complete ---\n");
+  DEBUG_PRINTF("\n--- %s ---\n", title);
   DEBUG_PRINTF("Estimated R  = %.4f Ohms\n", motor_R);
   DEBUG_PRINTF("Estimated L  = %.6f H\n", motor_L);
   DEBUG_PRINTF("Estimated Ke = %.4f V/(rad/s)\n", motor_Ke);
   DEBUG_PRINTF("Estimated Kt = %.4f Nm/A (Assumed = Ke)\n", motor_Kt);
   DEBUG_PRINTF("Estimated B  = %.6f Nm/(rad/s)\n", motor_B);
   DEBUG_PRINTF("Estimated J  = %.6f kg*m^2\n", motor_J);
+  DEBUG_PRINTF("Estimated Tc = %.5f Nm\n", motor_Tc);
+  if (friction_map_valid()) {
+    DEBUG_PRINTF("Friction map: Ts = %.5f/%.5f Nm, ws = %.3f rad/s\n",
+                 motor_friction.Ts[0], motor_friction.Ts[1], motor_friction.ws);
+  }
   DEBUG_PRINTF("---------------------------\n");
+}
 
-  // --- Main loop ---
-  while (1)
-  {
-    // Stop the motor after estimation for safety
-    DC_Ctl_Velo(0.0f); // Use the velocity controller to command zero speed
-    HAL_Delay(500);
-    // Or directly set PWM to 0 if controllers are just placeholders
-    // __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0);
-  }
+static bool reestimate_requested(void) {
+  // ... e.g. a button held during reset: return HAL_GPIO_ReadPin(...) == GPIO_PIN_RESET; ...
+  return false;
 }
 
 // --- System Configuration Functions (Implementations generated by CubeMX or written manually) ---
@@ -100,10 +246,59 @@ static void MX_GPIO_Init(void) {
 
 static void MX_ADC1_Init(void) {
   // ... ADC1 initialization code (ensure correct channel, trigger, etc.) ...
+  // Stream mode: ExternalTrigConv = TIM1_TRGO, rising edge, ContinuousConvMode = DISABLE,
+  // DMAContinuousRequests = ENABLE, DMA channel circular with half-word alignment
+  // Current loop: injected rank 1 = shunt channel, ExternalTrigInjecConv = T1_TRGO (rising edge),
+  // ADC IRQ enabled above the TIM1 update priority
 }
 
 static void MX_TIM1_Init(void) {
   // ... TIM1 initialization code (ensure PWM mode, channel, ARR value) ...
+  // CounterMode = CENTERALIGNED1, ARR = SYSCLK / (2 * PWM_FREQ_HZ), RepetitionCounter = 1,
+  // MasterOutputTrigger = TIM_TRGO_UPDATE (one ADC trigger per period, mid ON pulse)
+  // CH1 (leg A) and CH2 (leg B): PWM1 with complementary outputs (CH1N/CH2N), OCPreload enabled,
+  // BreakDeadTime.DeadTime matching BRIDGE_DEADTIME_NS at BRIDGE_TIM_CLK_HZ
+}
+
+static void MX_TIM2_Init(void) {
+  // ... TIM2 initialization code (encoder interface) ...
+  // EncoderMode = TIM_ENCODERMODE_TI12 (x4, ENCODER_CPR counts/rev), Period = 0xFFFF
+}
+
+static void MX_TIM5_Init(void) {
+  // ... TIM5 initialization code (edge timestamps) ...
+  // Prescaler = 0 (ENC_CAPTURE_CLK_HZ), Period = 0xFFFFFFFF, TI1 selection XOR (TI1S = 1) with
+  // encoder A on CH1 and B on CH2, IC1 on both edges: every encoder count latches CCR1
+}
+
+// --- TIM1 Update Callback ---
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+  if (htim->Instance == TIM1) {
+    lockin_pwm_update();
+    encoder_tick(); // Before anything that reads the velocity
+    current_loop_set_velocity(encoder_velocity_pll_q16()); // Back-EMF feedforward, integer only
+    mech_capture_tick();
+  }
+}
+
+// --- ADC Injected Conversion Callback ---
+void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc->Instance == ADC1) {
+    current_loop_isr((uint16_t)HAL_ADCEx_InjectedGetValue(hadc, ADC_INJECTED_RANK_1));
+  }
+}
+
+// --- ADC DMA Callbacks ---
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc->Instance == ADC1) {
+    adc_stream_half_complete();
+  }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc->Instance == ADC1) {
+    adc_stream_complete();
+  }
 }
 
 void Error_Handler(void) {
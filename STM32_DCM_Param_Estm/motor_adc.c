@@ -0,0 +1,188 @@
+#include "motor_adc.h"
+#include "motor_capture.h" // Raw sample capture of estimation phases
+
+// --- Stream State ---
+// All positions are free-running sample counts; the DMA buffer slot of count n is n % ADC_DMA_BUFFER_SIZE.
+static uint32_t consumed = 0;     // Next sample to hand out
+static uint32_t flush_base = 0;   // Sample count at the last flush (sample index 0)
+static bool overrun = false;      // Samples lost since the last flush
+
+#ifndef HOST_SIM
+
+#include "main.h"
+#include "motor_params_rl.h" // hadc1
+
+static uint16_t adc_dma_buffer[ADC_DMA_BUFFER_SIZE]; // Circular DMA target (double buffer)
+static volatile uint32_t produced = 0;               // Samples in completed halves (DMA callbacks)
+
+// Total number of samples the DMA has written so far
+// Combines the half-buffer count with the DMA counter so samples are usable
+// as soon as they are converted, not only after their half completes.
+// Restores the caller's interrupt mask, so callers may hold interrupts off across a flush.
+static uint32_t adc_write_count(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t done = produced;
+    uint32_t pos = ADC_DMA_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(hadc1.DMA_Handle);
+    __set_PRIMASK(primask);
+
+    if (pos >= ADC_DMA_BUFFER_SIZE) pos = 0; // Counter reload moment
+    uint32_t written = done - (done % ADC_DMA_BUFFER_SIZE) + pos;
+    if (written < done) written += ADC_DMA_BUFFER_SIZE; // Wrapped, transfer-complete callback still pending
+    return written;
+}
+
+void adc_stream_start(void) {
+    produced = 0;
+    consumed = 0;
+    flush_base = 0;
+    overrun = false;
+    // ADC1: external trigger TIM1_TRGO (rising edge), DMA circular, half-word, continuous requests
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)adc_dma_buffer, ADC_DMA_BUFFER_SIZE);
+}
+
+void adc_stream_stop(void) {
+    HAL_ADC_Stop_DMA(&hadc1);
+}
+
+void adc_stream_half_complete(void) {
+    produced += ADC_DMA_HALF_SIZE;
+}
+
+void adc_stream_complete(void) {
+    produced += ADC_DMA_HALF_SIZE;
+}
+
+void adc_stream_flush(void) {
+    consumed = adc_write_count();
+    flush_base = consumed;
+    overrun = false;
+    capture_flush(consumed);
+}
+
+uint32_t adc_stream_available(void) {
+    uint32_t written = adc_write_count();
+    if (written - consumed > ADC_DMA_BUFFER_SIZE - ADC_DMA_HALF_SIZE) {
+        // Reader fell behind: skip to the oldest half the DMA is not about to overwrite
+        consumed = written - (ADC_DMA_BUFFER_SIZE - ADC_DMA_HALF_SIZE);
+        overrun = true;
+    }
+    return written - consumed;
+}
+
+uint32_t adc_stream_read(uint16_t *dst, uint32_t max) {
+    uint32_t n = adc_stream_available();
+    if (n > max) n = max;
+    for (uint32_t i = 0; i < n; i++) {
+        dst[i] = adc_dma_buffer[(consumed + i) % ADC_DMA_BUFFER_SIZE];
+    }
+    capture_current(consumed, dst, n);
+    consumed += n;
+    return n;
+}
+
+bool adc_stream_read_block(uint16_t *dst, uint32_t n, uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    uint32_t got = 0;
+    while (got < n) {
+        got += adc_stream_read(&dst[got], n - got);
+        if (HAL_GetTick() - start > timeout_ms) return false;
+    }
+    return true;
+}
+
+#else // HOST_SIM
+
+static AdcSimWaveform sim_waveform = 0;
+static void *sim_ctx = 0;
+
+void adc_sim_set_waveform(AdcSimWaveform waveform, void *ctx) {
+    sim_waveform = waveform;
+    sim_ctx = ctx;
+}
+
+// Inverse of adc_raw_to_current() with the converter's clipping
+static uint16_t sim_sample(uint32_t index) {
+    float current = sim_waveform ? sim_waveform(index, sim_ctx) : 0.0f;
+    float counts = current * SHUNT_RESISTOR / V_REF * ADC_RESOLUTION + ADC_CURRENT_OFFSET + 0.5f;
+    if (counts < 0.0f) counts = 0.0f;
+    if (counts > ADC_RESOLUTION - 1) counts = ADC_RESOLUTION - 1;
+    return (uint16_t)counts;
+}
+
+void adc_stream_start(void) {
+    consumed = 0;
+    flush_base = 0;
+    overrun = false;
+}
+
+void adc_stream_stop(void) {
+}
+
+void adc_stream_half_complete(void) {
+}
+
+void adc_stream_complete(void) {
+}
+
+void adc_stream_flush(void) {
+    flush_base = consumed;
+    overrun = false;
+    capture_flush(consumed);
+}
+
+uint32_t adc_stream_available(void) {
+    return ADC_DMA_HALF_SIZE; // A simulated half buffer is always ready
+}
+
+uint32_t adc_stream_read(uint16_t *dst, uint32_t max) {
+    for (uint32_t i = 0; i < max; i++) {
+        dst[i] = sim_sample(consumed - flush_base + i);
+    }
+    capture_current(consumed, dst, max);
+    consumed += max;
+    return max;
+}
+
+bool adc_stream_read_block(uint16_t *dst, uint32_t n, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    adc_stream_read(dst, n);
+    return true;
+}
+
+#endif // HOST_SIM
+
+uint32_t adc_stream_index(void) {
+    return consumed - flush_base;
+}
+
+uint32_t adc_stream_position(void) {
+    return consumed;
+}
+
+bool adc_stream_overrun(void) {
+    return overrun;
+}
+
+float adc_raw_to_current(uint16_t raw) {
+    float voltage_at_shunt = ((float)((int32_t)raw - ADC_CURRENT_OFFSET) / ADC_RESOLUTION) * V_REF;
+    // Adjust calculation if using an amplifier for current sense
+    return voltage_at_shunt / SHUNT_RESISTOR;
+}
+
+float adc_stream_mean_current(uint32_t n) {
+    uint16_t block[32];
+    uint32_t sum = 0;
+    uint32_t left = n;
+    if (n == 0) return 0.0f;
+
+    while (left > 0) {
+        uint32_t chunk = (left < 32) ? left : 32;
+        if (!adc_stream_read_block(block, chunk, 100)) return 0.0f;
+        for (uint32_t i = 0; i < chunk; i++) sum += block[i];
+        left -= chunk;
+    }
+    // Average in raw counts, convert once
+    float mean_raw = (float)sum / (float)n - ADC_CURRENT_OFFSET;
+    return (mean_raw / ADC_RESOLUTION) * V_REF / SHUNT_RESISTOR;
+}
@@ -0,0 +1,114 @@
+#ifndef INC_MOTOR_ADC_H_
+#define INC_MOTOR_ADC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Sampling Configuration ---
+// TIM1 runs center-aligned; with RCR = 1 its update event (TRGO) fires once per period at the
+// counter underflow, which is the middle of the ON pulse. Sampling there sees the average
+// winding current without the switching ripple, at exactly one sample per PWM period.
+#define PWM_FREQ_HZ 20000U                      // TIM1 PWM frequency (Hz)
+#define ADC_SAMPLE_RATE_HZ PWM_FREQ_HZ          // One conversion per PWM period
+#define ADC_SAMPLE_PERIOD_S (1.0f / (float)ADC_SAMPLE_RATE_HZ)
+#define ADC_DMA_HALF_SIZE 128U                  // Samples per DMA half buffer (6.4 ms at 20 kHz)
+#define ADC_DMA_BUFFER_SIZE (2U * ADC_DMA_HALF_SIZE)
+
+// --- Current Sense Constants ---
+#define ADC_RESOLUTION 4096 // 12-bit ADC
+#define V_REF 3.3f          // ADC reference voltage (Volts)
+#define SHUNT_RESISTOR 0.1f // Shunt resistor value for current sensing (Ohms)
+// The H-bridge drives current both ways, so the shunt sits in the motor lead with a bidirectional
+// amplifier biased at mid-rail: zero current reads ADC_CURRENT_OFFSET (0 for a low-side shunt).
+#define ADC_CURRENT_OFFSET (ADC_RESOLUTION / 2)
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Starts timer-triggered conversions with circular DMA into the double buffer.
+ * @note Discards any samples still pending from a previous run.
+ */
+void adc_stream_start(void);
+
+/**
+ * @brief Stops conversions and DMA.
+ */
+void adc_stream_stop(void);
+
+/**
+ * @brief Discards all pending samples and clears the overrun flag.
+ * @note Call right before applying an excitation so sample 0 lines up with it. Leaves the
+ *       interrupt mask as found, so it may run inside the caller's critical section.
+ */
+void adc_stream_flush(void);
+
+/**
+ * @brief Number of samples ready to be read.
+ */
+uint32_t adc_stream_available(void);
+
+/**
+ * @brief Reads up to max samples without blocking.
+ * @return Number of raw samples copied to dst.
+ */
+uint32_t adc_stream_read(uint16_t *dst, uint32_t max);
+
+/**
+ * @brief Reads exactly n samples, waiting for them to arrive.
+ * @return false on timeout (dst then holds fewer than n valid samples).
+ */
+bool adc_stream_read_block(uint16_t *dst, uint32_t n, uint32_t timeout_ms);
+
+/**
+ * @brief Index of the next sample to be read, counted from the last flush.
+ * @note Sample k was taken k * ADC_SAMPLE_PERIOD_S after the flush.
+ */
+uint32_t adc_stream_index(void);
+
+/**
+ * @brief Samples handed out since adc_stream_start() (not reset by a flush).
+ */
+uint32_t adc_stream_position(void);
+
+/**
+ * @brief True if samples were overwritten before being read since the last flush.
+ */
+bool adc_stream_overrun(void);
+
+/**
+ * @brief Converts a raw ADC sample to motor current.
+ * @return Current in Amps.
+ */
+float adc_raw_to_current(uint16_t raw);
+
+/**
+ * @brief Averages the next n samples (blocking).
+ * @return Mean current in Amps, 0 on timeout.
+ */
+float adc_stream_mean_current(uint32_t n);
+
+/**
+ * @brief DMA callbacks, call from HAL_ADC_ConvHalfCpltCallback / HAL_ADC_ConvCpltCallback.
+ */
+void adc_stream_half_complete(void);
+void adc_stream_complete(void);
+
+#ifdef HOST_SIM
+// --- Host Stand-in ---
+// With HOST_SIM defined no HAL is used: samples are produced on demand from a synthetic
+// waveform evaluated at each sample index, so estimators can run against known signals.
+
+/**
+ * @brief Synthetic current source.
+ * @param sample_index Index of the sample since the last flush.
+ * @return Motor current in Amps.
+ */
+typedef float (*AdcSimWaveform)(uint32_t sample_index, void *ctx);
+
+/**
+ * @brief Selects the waveform fed into the sample stream (NULL gives 0 A).
+ */
+void adc_sim_set_waveform(AdcSimWaveform waveform, void *ctx);
+#endif
+
+#endif /* INC_MOTOR_ADC_H_ */
@@ -0,0 +1,66 @@
+#include "motor_bridge.h"
+#include "motor_params_rl.h" // htim1, V_SUPPLY
+#include "motor_adc.h"       // ADC_RESOLUTION, V_REF, SHUNT_RESISTOR
+
+// --- Bridge State ---
+static int32_t arr = 0;              // TIM1 ARR (full-scale bridge counts)
+static int32_t mid = 0;              // ARR / 2 (0 V, both legs at 50 %)
+static float counts_per_volt = 0.0f;
+static int32_t comp_band = 1;        // BRIDGE_COMP_BAND_A in ADC counts
+static int32_t comp_slope_q16 = 0;   // Compensation per ADC count of current (Q16)
+static volatile int32_t comp = 0;    // Current dead-time compensation (bridge counts)
+static volatile int32_t output = 0;  // Last requested bridge counts
+
+// --- Public Functions ---
+
+void bridge_start(void) {
+    float counts_per_amp = (float)ADC_RESOLUTION * SHUNT_RESISTOR / V_REF;
+
+    arr = (int32_t)htim1.Instance->ARR;
+    mid = arr >> 1;
+    counts_per_volt = (float)arr / V_SUPPLY;
+    comp_band = (int32_t)(BRIDGE_COMP_BAND_A * counts_per_amp + 0.5f);
+    if (comp_band < 1) comp_band = 1;
+    comp_slope_q16 = (int32_t)((BRIDGE_DEADTIME_TICKS << 16) / (uint32_t)comp_band);
+    comp = 0;
+
+    bridge_write(0);
+#ifndef HOST_SIM
+    HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
+    HAL_TIMEx_PWMN_Start(&htim1, TIM_CHANNEL_1);
+    HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2);
+    HAL_TIMEx_PWMN_Start(&htim1, TIM_CHANNEL_2);
+#endif
+}
+
+int32_t bridge_volts_to_counts(float volts) {
+    return (int32_t)(volts * counts_per_volt + (volts >= 0.0f ? 0.5f : -0.5f));
+}
+
+void bridge_write(int32_t counts) {
+    if (counts > arr) counts = arr;
+    if (counts < -arr) counts = -arr;
+    output = counts;
+
+    int32_t c = counts + comp;
+    if (c > arr) c = arr;
+    if (c < -arr) c = -arr;
+    int32_t ccr_a = mid + (c >> 1);
+    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, (uint32_t)ccr_a);
+    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, (uint32_t)(arr - ccr_a));
+}
+
+void bridge_set_current(int32_t counts) {
+    if (counts > comp_band) counts = comp_band;
+    if (counts < -comp_band) counts = -comp_band;
+    comp = (counts * comp_slope_q16) >> 16;
+    bridge_write(output); // Voltage-mode outputs are written rarely, keep them compensated
+}
+
+int32_t bridge_output(void) {
+    return output;
+}
+
+float bridge_voltage(void) {
+    return (counts_per_volt > 0.0f) ? (float)output / counts_per_volt : 0.0f;
+}
@@ -0,0 +1,61 @@
+#ifndef INC_MOTOR_BRIDGE_H_
+#define INC_MOTOR_BRIDGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- H-Bridge Configuration ---
+// Leg A on TIM1 CH1/CH1N, leg B on CH2/CH2N, complementary outputs with hardware dead time
+// (BDTR.DTG). Both legs switch around 50 % duty: CCR1 = ARR/2 + c/2, CCR2 = ARR - CCR1, so the
+// bridge voltage is V_SUPPLY * c / ARR for any signed c in [-ARR, ARR] ("bridge counts").
+// That is the same scale the unipolar compare used, so precomputed compare tables carry over.
+#define BRIDGE_TIM_CLK_HZ 168000000U   // TIM1 counter clock (Hz)
+#define BRIDGE_DEADTIME_NS 500U        // Must match the DTG setting in MX_TIM1_Init
+#define BRIDGE_DEADTIME_TICKS (BRIDGE_DEADTIME_NS * (BRIDGE_TIM_CLK_HZ / 1000000U) / 1000U)
+#define BRIDGE_COMP_BAND_A 0.05f       // |i| over which the compensation ramps through zero current
+
+// --- Dead-Time Compensation ---
+// During each dead time the free-wheeling diode of the switching leg sets its voltage, which
+// costs one dead time of volt-seconds per leg and period against the current direction:
+// with the center-aligned carrier (period 2*ARR ticks) the bridge loses sign(i) * DEADTIME_TICKS
+// bridge counts. The same amount is added back, ramped linearly inside BRIDGE_COMP_BAND_A so the
+// correction does not chatter while the current crosses zero.
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Precomputes the voltage scaling from TIM1 ARR and starts all four outputs at 0 V.
+ * @note Call once after MX_TIM1_Init(), instead of HAL_TIM_PWM_Start().
+ */
+void bridge_start(void);
+
+/**
+ * @brief Bridge counts for a voltage (one multiply, no divide).
+ */
+int32_t bridge_volts_to_counts(float volts);
+
+/**
+ * @brief Sets the bridge output.
+ * @note Integer only and safe from any interrupt; clamps to [-ARR, ARR].
+ * @param counts Signed voltage in bridge counts (V_SUPPLY * counts / ARR).
+ */
+void bridge_write(int32_t counts);
+
+/**
+ * @brief Latest measured current (ADC counts, offset removed) for the compensation.
+ * @note Called from the injected ADC interrupt every PWM period; re-applies the last output
+ *       with the new compensation.
+ */
+void bridge_set_current(int32_t counts);
+
+/**
+ * @brief Last requested output (bridge counts, before compensation).
+ */
+int32_t bridge_output(void);
+
+/**
+ * @brief Last requested output in Volts.
+ */
+float bridge_voltage(void);
+
+#endif /* INC_MOTOR_BRIDGE_H_ */
@@ -0,0 +1,226 @@
+#include "motor_capture.h"
+#include <string.h>
+#include "motor_params_rl.h" // htim1, V_SUPPLY, motor_R, motor_L
+#include "motor_params_jb.h" // motor_Ke, motor_Kt, motor_J, motor_B
+
+#define CAPTURE_MAX_CURRENT 64U // Samples merged into one current record
+
+// --- Capture State ---
+static bool enabled = false;
+static CapturePhase phase = 0;       // 0 = no phase open
+static uint32_t dropped = 0;         // Records lost in the current phase
+
+// Contiguous current samples waiting to be written as one record
+static uint32_t cur_index = 0;
+static uint16_t cur_raw[CAPTURE_MAX_CURRENT];
+static uint32_t cur_n = 0;
+
+// Velocity batch (capture_velocity_sample)
+static uint32_t vel_first = 0;
+static uint32_t vel_rate = 0;
+static float vel_buf[CAPTURE_VELOCITY_BATCH];
+static uint32_t vel_n = 0;
+
+// --- Output Backend ---
+
+#ifndef HOST_SIM
+
+#include "SEGGER_RTT.h"
+
+static uint8_t rtt_buffer[CAPTURE_RTT_BUFFER_SIZE];
+
+static void backend_open(void) {
+    // Skip mode: a record goes out whole or not at all, the estimators never wait for the host
+    SEGGER_RTT_ConfigUpBuffer(CAPTURE_RTT_CHANNEL, "DcmCapture", rtt_buffer, sizeof(rtt_buffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+static bool backend_write(const uint8_t *data, uint32_t len) {
+    return SEGGER_RTT_Write(CAPTURE_RTT_CHANNEL, data, len) == len;
+}
+
+#else // HOST_SIM
+
+static FILE *sim_file = NULL;
+
+void capture_sim_set_file(FILE *file) {
+    sim_file = file;
+}
+
+static void backend_open(void) {
+}
+
+static bool backend_write(const uint8_t *data, uint32_t len) {
+    return sim_file != NULL && fwrite(data, 1, len, sim_file) == len;
+}
+
+#endif // HOST_SIM
+
+// --- Record Encoding ---
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return put_u32(p, u);
+}
+
+// Fills in the record header and writes the record; rec points at the header
+static void emit(uint8_t *rec, uint8_t *end, CaptureRecord type, uint8_t tag) {
+    uint32_t len = (uint32_t)(end - rec);
+    rec[0] = (uint8_t)type;
+    rec[1] = tag;
+    put_u16(&rec[2], (uint16_t)(len - 4U));
+    if (!backend_write(rec, len)) dropped++;
+}
+
+static void flush_current(void) {
+    uint8_t rec[8 + 2 * CAPTURE_MAX_CURRENT];
+    if (cur_n == 0) return;
+    uint8_t *p = put_u32(&rec[4], cur_index);
+    for (uint32_t i = 0; i < cur_n; i++) p = put_u16(p, cur_raw[i]);
+    emit(rec, p, CAP_REC_CURRENT, 0);
+    cur_n = 0;
+}
+
+static void flush_velocity(void) {
+    if (vel_n == 0) return;
+    uint32_t n = vel_n;
+    vel_n = 0;
+    capture_velocity(vel_first, vel_rate, vel_buf, n);
+}
+
+// --- Public Functions ---
+
+void capture_start(void) {
+    uint8_t rec[4 + 30];
+    backend_open();
+    enabled = true;
+    phase = 0;
+
+    uint8_t *p = put_u32(&rec[4], CAPTURE_MAGIC);
+    p = put_u16(p, CAPTURE_VERSION);
+    p = put_u16(p, ADC_RESOLUTION);
+    p = put_f32(p, V_REF);
+    p = put_f32(p, SHUNT_RESISTOR);
+    p = put_f32(p, V_SUPPLY);
+    p = put_u32(p, ADC_SAMPLE_RATE_HZ);
+    p = put_u32(p, htim1.Instance->ARR);
+    p = put_u16(p, ADC_CURRENT_OFFSET);
+    emit(rec, p, CAP_REC_STREAM, 0);
+}
+
+bool capture_enabled(void) {
+    return enabled;
+}
+
+void capture_phase_begin(CapturePhase new_phase, const float *params) {
+    uint8_t rec[4 + 48];
+    if (!enabled) return;
+    if (phase != 0) capture_phase_end(false, NULL); // Previous phase aborted
+
+    phase = new_phase;
+    dropped = 0;
+    cur_n = 0;
+    vel_n = 0;
+
+    uint8_t *p = put_u32(&rec[4], HAL_GetTick());
+    p = put_u32(p, adc_stream_position());
+    for (uint8_t i = 0; i < 4; i++) p = put_f32(p, params ? params[i] : 0.0f);
+    p = put_f32(p, motor_R);
+    p = put_f32(p, motor_L);
+    p = put_f32(p, motor_Ke);
+    p = put_f32(p, motor_Kt);
+    p = put_f32(p, motor_J);
+    p = put_f32(p, motor_B);
+    emit(rec, p, CAP_REC_PHASE_BEGIN, (uint8_t)phase);
+}
+
+void capture_phase_end(bool ok, const float *results) {
+    uint8_t rec[4 + 30];
+    if (!enabled || phase == 0) return;
+    flush_current();
+    flush_velocity();
+
+    uint8_t *p = put_u32(&rec[4], HAL_GetTick());
+    p = put_u32(p, dropped);
+    p = put_u32(p, ok ? 1U : 0U);
+    for (uint8_t i = 0; i < 4; i++) p = put_f32(p, results ? results[i] : 0.0f);
+    emit(rec, p, CAP_REC_PHASE_END, (uint8_t)phase);
+    phase = 0;
+}
+
+void capture_flush(uint32_t index) {
+    uint8_t rec[8];
+    if (!enabled || phase == 0) return;
+    flush_current();
+    emit(rec, put_u32(&rec[4], index), CAP_REC_FLUSH, 0);
+}
+
+void capture_current(uint32_t index, const uint16_t *raw, uint32_t n) {
+    if (!enabled || phase == 0) return;
+    for (uint32_t i = 0; i < n; i++) {
+        // Merge contiguous reads; a gap or a full record starts a new one
+        if (cur_n > 0 && (cur_n == CAPTURE_MAX_CURRENT || index + i != cur_index + cur_n)) flush_current();
+        if (cur_n == 0) cur_index = index + i;
+        cur_raw[cur_n++] = raw[i];
+    }
+}
+
+void capture_voltage(uint32_t index, float volts) {
+    uint8_t rec[12];
+    if (!enabled || phase == 0) return;
+    flush_current(); // Keep records in time order
+    uint8_t *p = put_u32(&rec[4], index);
+    p = put_f32(p, volts);
+    emit(rec, p, CAP_REC_VOLTAGE, 0);
+}
+
+void capture_velocity(uint32_t first, uint32_t rate_hz, const float *w, uint32_t n) {
+    uint8_t rec[12 + 4 * CAPTURE_VELOCITY_BATCH];
+    if (!enabled || phase == 0) return;
+    while (n > 0) {
+        uint32_t chunk = (n < CAPTURE_VELOCITY_BATCH) ? n : CAPTURE_VELOCITY_BATCH;
+        uint8_t *p = put_u32(&rec[4], first);
+        p = put_u32(p, rate_hz);
+        for (uint32_t i = 0; i < chunk; i++) p = put_f32(p, w[i]);
+        emit(rec, p, CAP_REC_VELOCITY, 0);
+        first += chunk;
+        w += chunk;
+        n -= chunk;
+    }
+}
+
+void capture_point(float velocity, float current) {
+    uint8_t rec[12];
+    if (!enabled || phase == 0) return;
+    flush_current();
+    uint8_t *p = put_f32(&rec[4], velocity);
+    p = put_f32(p, current);
+    emit(rec, p, CAP_REC_POINT, 0);
+}
+
+void capture_velocity_sample(uint32_t index, uint32_t rate_hz, float w) {
+    if (!enabled || phase == 0) return;
+    if (vel_n > 0 && (vel_n == CAPTURE_VELOCITY_BATCH || index != vel_first + vel_n || rate_hz != vel_rate)) {
+        flush_velocity();
+    }
+    if (vel_n == 0) {
+        vel_first = index;
+        vel_rate = rate_hz;
+    }
+    vel_buf[vel_n++] = w;
+}
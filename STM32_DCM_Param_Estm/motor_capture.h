@@ -0,0 +1,118 @@
+#ifndef INC_MOTOR_CAPTURE_H_
+#define INC_MOTOR_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Capture Configuration ---
+// Raw samples of every estimation phase go out on their own RTT up channel, so the
+// DEBUG_PRINTF text on channel 0 is untouched. Record it with e.g.
+//   JLinkRTTLogger -Device STM32F407VG -If SWD -Speed 4000 -RTTChannel 1 run_0001.dcmc
+// and re-analyze the files with host/dcm_replay (the chirp phase with host/dcm_fit).
+#define CAPTURE_RTT_CHANNEL 1U
+#define CAPTURE_RTT_BUFFER_SIZE 8192U // ~200 ms of current samples at 20 kHz
+#define CAPTURE_VERSION 2U
+#define CAPTURE_VELOCITY_BATCH 32U     // Velocity samples per record
+
+// --- Record Format ---
+// Little-endian byte stream of records: u8 type, u8 tag, u16 payload length, payload.
+// Current and voltage indices are absolute ADC stream sample counts (ADC_SAMPLE_RATE_HZ);
+// a phase's time zero is its first CAP_REC_FLUSH (the instant the excitation was applied).
+typedef enum {
+    CAP_REC_STREAM = 1,   // u32 magic, u16 version, u16 adc_resolution, f32 v_ref, f32 shunt,
+                          // f32 v_supply, u32 adc_rate_hz, u32 pwm_arr, u16 adc_offset (v2)
+    CAP_REC_PHASE_BEGIN,  // tag = phase; u32 tick_ms, u32 index, f32 params[4], f32 R, L, Ke, Kt, J, B
+    CAP_REC_FLUSH,        // u32 index
+    CAP_REC_CURRENT,      // u32 index, u16 raw[]
+    CAP_REC_VOLTAGE,      // u32 index, f32 volts (new terminal voltage set point)
+    CAP_REC_VELOCITY,     // u32 first, u32 rate_hz, f32 rad_s[] (own time base)
+    CAP_REC_PHASE_END,    // tag = phase; u32 tick_ms, u32 dropped, u32 ok, f32 results[4]
+    CAP_REC_POINT         // f32 rad_s, f32 amps (one steady-state operating point)
+} CaptureRecord;
+
+#define CAPTURE_MAGIC 0x434D4344UL // "DCMC"
+
+// --- Estimation Phases ---
+// params[] / results[] per phase:
+typedef enum {
+    CAP_PHASE_R = 1,       // [V]                      -> [R]
+    CAP_PHASE_L_STEP,      // [V, R]                   -> [L, tau_s]
+    CAP_PHASE_L_SINE,      // [A, f, R]                -> [L, Z]
+    CAP_PHASE_L_LOCKIN,    // [A, f, cycles]           -> [L, z_re, z_im, f_actual]
+    CAP_PHASE_RL_SPECTRUM, // [A, f_min, f_max, tones] -> [R0, L0, R_slope, L_slope]
+    CAP_PHASE_KE,          // [w_cmd, R]               -> [Ke, V, I, w]
+    CAP_PHASE_B,           // [w_cmd, Kt]              -> [B, I, w]
+    CAP_PHASE_J,           // [I_step, Kt, n_step]     -> [J, B, Tc, rms]
+    CAP_PHASE_FRICTION,    // [w_min, w_max, points, Kt] -> [Tc, Ts, ws, B] (direction means)
+    CAP_PHASE_CHIRP        // [A, f_start, f_end, duration] -> [growth, samples, amp, velocity_lost]
+                           // (voltage per motor_lockin.h ChirpResult, velocity at CHIRP_VELOCITY_RATE_HZ)
+} CapturePhase;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Configures the RTT channel and writes the stream header.
+ * @note Records are dropped, never waited for, when the host does not keep up.
+ *       Call after MX_TIM1_Init() (the header records the PWM period) and before the
+ *       ADC stream starts.
+ */
+void capture_start(void);
+
+/**
+ * @brief True while capturing.
+ */
+bool capture_enabled(void);
+
+/**
+ * @brief Opens a phase; samples are recorded until capture_phase_end().
+ * @param params Up to four phase parameters (see CapturePhase), may be NULL.
+ */
+void capture_phase_begin(CapturePhase phase, const float *params);
+
+/**
+ * @brief Closes the current phase with its results.
+ * @param results Up to four results (see CapturePhase), may be NULL.
+ */
+void capture_phase_end(bool ok, const float *results);
+
+/**
+ * @brief Records a stream flush (called by adc_stream_flush()).
+ */
+void capture_flush(uint32_t index);
+
+/**
+ * @brief Records raw current samples handed to an estimator (called by adc_stream_read()).
+ */
+void capture_current(uint32_t index, const uint16_t *raw, uint32_t n);
+
+/**
+ * @brief Records a new terminal voltage set point (called by set_Vs()).
+ */
+void capture_voltage(uint32_t index, float volts);
+
+/**
+ * @brief Records a block of velocity samples.
+ * @param first Index of w[0] in the phase's velocity time base.
+ */
+void capture_velocity(uint32_t first, uint32_t rate_hz, const float *w, uint32_t n);
+
+/**
+ * @brief Adds one velocity sample to a batch written every CAPTURE_VELOCITY_BATCH samples.
+ * @note The batch is also written by capture_phase_end().
+ */
+void capture_velocity_sample(uint32_t index, uint32_t rate_hz, float w);
+
+/**
+ * @brief Records one steady-state point (velocity and current) of a sweep.
+ */
+void capture_point(float velocity, float current);
+
+#ifdef HOST_SIM
+#include <stdio.h>
+/**
+ * @brief Host builds write the record stream to a file instead of RTT.
+ */
+void capture_sim_set_file(FILE *file);
+#endif
+
+#endif /* INC_MOTOR_CAPTURE_H_ */
@@ -0,0 +1,155 @@
+#include "motor_current_loop.h"
+#include "motor_params_rl.h" // htim1, V_SUPPLY
+#include "motor_adc.h"       // ADC_RESOLUTION, V_REF, SHUNT_RESISTOR, ADC_SAMPLE_PERIOD_S
+#include "motor_bridge.h"    // Signed H-bridge output
+#include "motor_encoder.h"   // ENCODER_CPR, ENC_UPDATE_RATE_HZ (PLL velocity units)
+
+#define COUNTS_PER_AMP ((float)ADC_RESOLUTION * SHUNT_RESISTOR / V_REF)
+#define GAIN_MAX (1L << 18) // |kp * e| stays below 2^30 for any 12-bit error
+#define RAD_S_PER_PLL_LSB (2.0f * (float)M_PI / (float)ENCODER_CPR * (float)ENC_UPDATE_RATE_HZ / 65536.0f)
+
+// --- Loop State ---
+// Everything the ISR reads is in bridge counts and ADC counts; the float model is
+// converted once by current_loop_configure() / current_loop_set_reference().
+static volatile bool enabled = false;
+static float ccr_per_volt = 0.0f;  // Compare counts per Volt
+static float r_ohm = 0.0f;
+static float l_henry = 0.0f;
+static float ref_amps = 0.0f;
+static int32_t kp_q = 0;           // Compare counts per ADC count (Q kp_shift)
+static uint8_t kp_shift = CURRENT_LOOP_Q;
+static int32_t ki_q = 0;           // Same, per sample (Q)
+static int32_t ke_q = 0;           // Compare counts of back-EMF per PLL velocity LSB (Q32)
+static int32_t ref_counts = 0;     // Reference (ADC counts)
+static int32_t ff_r = 0;           // R * i_ref (compare counts)
+static volatile int32_t ff_bemf = 0; // Ke * w (compare counts)
+static volatile int32_t ff_kick = 0; // L * di_ref/dt, applied for one period after a reference change
+static int32_t integ_q = 0;        // Integrator (compare counts, Q)
+static int32_t out_max = 0;
+static volatile int32_t out_counts = 0;
+
+// --- Tick Means ---
+// Every injected sample and the bridge output it was taken under, summed until
+// current_loop_take_means() collects them (64-bit: no overflow however rarely it is called)
+static volatile int64_t mean_i_sum = 0; // ADC counts, offset removed
+static volatile int64_t mean_v_sum = 0; // Bridge counts
+static volatile uint32_t mean_n = 0;
+
+// --- Internal Helper Functions ---
+
+// Gain with shift fraction bits; false if it does not fit GAIN_MAX
+static bool to_gain_q(float ccr_per_count, uint8_t shift, int32_t *gain) {
+    float q = ccr_per_count * (float)(1L << shift);
+    if (q < 0.0f || q > (float)GAIN_MAX) return false;
+    *gain = (int32_t)(q + 0.5f);
+    return true;
+}
+
+// --- Public Functions ---
+
+bool current_loop_configure(float R, float L, float Ke) {
+    if (R < 0.001f || L <= 0.0f) return false;
+
+    float wc = 2.0f * (float)M_PI * CURRENT_LOOP_BANDWIDTH_HZ;
+    float arr = (float)htim1.Instance->ARR;
+    float per_count = (arr / V_SUPPLY) / COUNTS_PER_AMP; // V/A -> compare counts per ADC count
+
+    // Kp grows with L: above a few mH it trades fraction bits for range instead of clipping
+    int32_t kp, ki;
+    uint8_t shift = CURRENT_LOOP_Q;
+    while (!to_gain_q(L * wc * per_count, shift, &kp)) {
+        if (shift == 0) return false;
+        shift--;
+    }
+    if (!to_gain_q(R * wc * ADC_SAMPLE_PERIOD_S * per_count, CURRENT_LOOP_Q, &ki)) return false;
+    float ke = Ke * (arr / V_SUPPLY) * RAD_S_PER_PLL_LSB * 4294967296.0f;
+    if (ke < 0.0f || ke >= (float)INT32_MAX) return false; // Ke above ~15 V/(rad/s)
+
+    __disable_irq();
+    ccr_per_volt = arr / V_SUPPLY;
+    ke_q = (int32_t)(ke + 0.5f);
+    r_ohm = R;
+    l_henry = L;
+    kp_q = kp;
+    kp_shift = shift;
+    ki_q = ki;
+    out_max = (int32_t)htim1.Instance->ARR;
+    __enable_irq();
+    return true;
+}
+
+void current_loop_set_reference(float amps) {
+    float per_count = ccr_per_volt / COUNTS_PER_AMP;
+    int32_t counts = (int32_t)(amps * COUNTS_PER_AMP + (amps >= 0.0f ? 0.5f : -0.5f));
+    float kick = l_henry * (amps - (enabled ? ref_amps : 0.0f)) / ADC_SAMPLE_PERIOD_S * ccr_per_volt;
+
+    __disable_irq();
+    if (!enabled) integ_q = 0;
+    ref_amps = amps;
+    ref_counts = counts;
+    ff_r = (int32_t)(r_ohm * (float)counts * per_count);
+    ff_kick = (int32_t)kick;
+    enabled = (kp_q > 0);
+    __enable_irq();
+}
+
+void current_loop_set_velocity(int32_t pll_velocity) {
+    ff_bemf = (int32_t)(((int64_t)ke_q * pll_velocity) >> 32);
+}
+
+void current_loop_disable(void) {
+    enabled = false;
+}
+
+bool current_loop_enabled(void) {
+    return enabled;
+}
+
+float current_loop_voltage(void) {
+    return (ccr_per_volt > 0.0f) ? (float)out_counts / ccr_per_volt : 0.0f;
+}
+
+bool current_loop_take_means(float *amps, float *volts) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    int64_t i_sum = mean_i_sum, v_sum = mean_v_sum;
+    uint32_t n = mean_n;
+    mean_i_sum = 0;
+    mean_v_sum = 0;
+    mean_n = 0;
+    __set_PRIMASK(primask);
+
+    if (n == 0) return false;
+    *amps = (float)i_sum / ((float)n * COUNTS_PER_AMP);
+    *volts = (float)v_sum * V_SUPPLY / ((float)n * (float)htim1.Instance->ARR);
+    return true;
+}
+
+void current_loop_isr(uint16_t raw) {
+    int32_t measured = (int32_t)raw - ADC_CURRENT_OFFSET;
+    mean_i_sum += measured;
+    mean_v_sum += bridge_output(); // Output of the period this sample was taken in
+    mean_n++;
+    bridge_set_current(measured); // Dead-time compensation follows the current in every mode
+    if (!enabled) return;
+
+    int32_t e = ref_counts - measured;
+    int32_t u = ((kp_q * e) >> kp_shift) + (integ_q >> CURRENT_LOOP_Q) + ff_r + ff_bemf + ff_kick;
+    ff_kick = 0;
+
+    // Conditional integration: a saturated output only integrates errors that pull it back
+    if (u > out_max) {
+        u = out_max;
+        if (e < 0) integ_q += ki_q * e;
+    } else if (u < -out_max) {
+        u = -out_max;
+        if (e > 0) integ_q += ki_q * e;
+    } else {
+        integ_q += ki_q * e;
+    }
+    if (integ_q > (out_max << CURRENT_LOOP_Q)) integ_q = out_max << CURRENT_LOOP_Q;
+    if (integ_q < -(out_max << CURRENT_LOOP_Q)) integ_q = -(out_max << CURRENT_LOOP_Q);
+
+    bridge_write(u);
+    out_counts = u;
+}
@@ -0,0 +1,79 @@
+#ifndef INC_MOTOR_CURRENT_LOOP_H_
+#define INC_MOTOR_CURRENT_LOOP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Current Loop Configuration ---
+// PI with pole-zero cancellation (Kp = L*wc, Ki = R*wc) plus feedforward of the model
+// V = R*i_ref + L*di_ref/dt + Ke*w, so the closed loop is a first-order lag at wc.
+// Runs once per PWM period from the injected ADC end-of-conversion interrupt: ADC1 injected
+// rank 1 is the shunt channel, triggered by TIM1_TRGO like the regular DMA stream, so the loop
+// sees every sample without touching the stream the estimators read.
+#define CURRENT_LOOP_BANDWIDTH_HZ 2000.0f // ~fs/10: leaves phase margin for the 1.5 sample delay
+#define CURRENT_LOOP_Q 12U                // Fraction bits of Ki and the integrator (and of Kp unless L is large)
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Computes the fixed-point gains and feedforward from a motor model.
+ * @note Call with the loop disabled or between estimations; the ISR never sees a half update.
+ * @param R Winding resistance (Ohms).
+ * @param L Winding inductance (H).
+ * @param Ke Back-EMF constant (V/(rad/s)).
+ * @return false if R or L is not a usable estimate, or R or Ke is too large for the
+ *         fixed-point gains (nothing is changed then).
+ * @note Kp keeps CURRENT_LOOP_Q fraction bits up to L of about 1.8 mH (12 V, 0.1 Ohm shunt),
+ *       fewer above that instead of clipping.
+ */
+bool current_loop_configure(float R, float L, float Ke);
+
+/**
+ * @brief Sets the current reference and hands the PWM compare to the loop.
+ * @note The R and L feedforward land the first period close to the reference; the integrator
+ *       only trims what the model misses.
+ */
+void current_loop_set_reference(float amps);
+
+/**
+ * @brief Updates the velocity used for back-EMF feedforward; integer only.
+ * @note Call from the TIM1 update interrupt after encoder_tick().
+ * @param pll_velocity encoder_velocity_pll_q16() (Q16 counts per ENC_UPDATE_RATE_HZ update).
+ */
+void current_loop_set_velocity(int32_t pll_velocity);
+
+/**
+ * @brief Releases the PWM compare (voltage-mode writers call this first).
+ */
+void current_loop_disable(void);
+
+/**
+ * @brief True while the loop owns the PWM compare.
+ */
+bool current_loop_enabled(void);
+
+/**
+ * @brief Last output voltage (V), for read_Vs() and diagnostics.
+ */
+float current_loop_voltage(void);
+
+/**
+ * @brief Mean current and bridge voltage over the PWM periods since the last call.
+ * @note Non-blocking: current_loop_isr() accumulates every injected sample, so a periodic
+ *       task gets the mean of its own period without reading the DMA stream.
+ * @param amps Mean motor current (A).
+ * @param volts Mean requested bridge voltage (V, before dead-time compensation).
+ * @return false if no sample arrived since the last call.
+ */
+bool current_loop_take_means(float *amps, float *volts);
+
+/**
+ * @brief One PI update; integer only.
+ * @note Call from HAL_ADCEx_InjectedConvCpltCallback with the injected sample.
+ * @note Also feeds the bridge dead-time compensation and the tick means, so it is called with
+ *       the loop disabled too.
+ * @param raw Shunt current sample (ADC counts).
+ */
+void current_loop_isr(uint16_t raw);
+
+#endif /* INC_MOTOR_CURRENT_LOOP_H_ */
@@ -0,0 +1,151 @@
+#include "motor_encoder.h"
+#include <math.h>
+
+#define RAD_PER_COUNT (2.0f * (float)M_PI / (float)ENCODER_CPR)
+#define STOP_TIMEOUT_TICKS ((uint32_t)(ENC_STOP_TIMEOUT_S * (float)ENC_CAPTURE_CLK_HZ))
+
+// --- Estimator State ---
+static EncoderMode mode = ENC_MODE_MT;
+static uint16_t prev_count = 0;
+static int32_t position = 0;        // Accumulated counts
+
+// M/T: counts between two timestamped edges
+static bool mt_valid = false;       // mt_edge_* hold a usable reference edge
+static int32_t mt_edge_position = 0;
+static uint32_t mt_edge_time = 0;
+static float mt_velocity = 0.0f;    // rad/s
+
+// PLL: Q16 counts, wraps modulo 2^32 together with the measured position
+static uint32_t pll_position = 0;   // Q16 counts
+static int32_t pll_velocity = 0;    // Q16 counts per update
+static int32_t pll_kp = 0;          // Q16, 2*zeta*wn*Ts
+static int32_t pll_ki = 0;          // Q16, (wn*Ts)^2
+
+// --- Estimators ---
+
+void encoder_process(uint16_t count, uint32_t edge_time, uint32_t now) {
+    position += (int16_t)(count - prev_count);
+    prev_count = count;
+
+    // --- M/T ---
+    // Count difference over the exact time between the edges that produced it: resolution
+    // is one capture clock, not one count, so low speeds stay smooth.
+    if (position != mt_edge_position) {
+        if (mt_valid) {
+            uint32_t dt = edge_time - mt_edge_time;
+            if (dt > 0U) {
+                mt_velocity = (float)(position - mt_edge_position) * (RAD_PER_COUNT * (float)ENC_CAPTURE_CLK_HZ) / (float)dt;
+            }
+        }
+        mt_edge_position = position;
+        mt_edge_time = edge_time;
+        mt_valid = true;
+    } else if (mt_valid) {
+        // No new edge: the speed can be at most one count over the time since the last one
+        uint32_t idle = now - mt_edge_time;
+        if (idle > STOP_TIMEOUT_TICKS) {
+            mt_velocity = 0.0f;
+            mt_valid = false; // Next edge only re-seeds (capture timer may have wrapped)
+        } else if (idle > 0U) {
+            float bound = (RAD_PER_COUNT * (float)ENC_CAPTURE_CLK_HZ) / (float)idle;
+            if (mt_velocity > bound) mt_velocity = bound;
+            else if (mt_velocity < -bound) mt_velocity = -bound;
+        }
+    }
+
+    // --- PLL ---
+    // Type-2 tracking loop: zero steady-state error at constant speed. Its input is the count
+    // plus the fraction travelled since the last edge (from the M/T speed), so it does not
+    // see the one-count staircase.
+    float frac = 0.0f;
+    if (mt_valid) {
+        frac = (float)(now - mt_edge_time) * (mt_velocity / (RAD_PER_COUNT * (float)ENC_CAPTURE_CLK_HZ));
+        if (frac > 0.99f) frac = 0.99f;
+        else if (frac < -0.99f) frac = -0.99f;
+    }
+    uint32_t measured = ((uint32_t)position << 16) + (uint32_t)(int32_t)(frac * 65536.0f);
+    int32_t error = (int32_t)(measured - pll_position);
+    pll_velocity += (int32_t)(((int64_t)pll_ki * error) >> 16);
+    pll_position += (uint32_t)(pll_velocity + (int32_t)(((int64_t)pll_kp * error) >> 16));
+}
+
+float encoder_velocity_mt(void) {
+    return mt_velocity;
+}
+
+float encoder_velocity_pll(void) {
+    return (float)pll_velocity * (RAD_PER_COUNT * (float)ENC_UPDATE_RATE_HZ / 65536.0f);
+}
+
+int32_t encoder_velocity_pll_q16(void) {
+    return pll_velocity;
+}
+
+float encoder_velocity(void) {
+    return (mode == ENC_MODE_PLL) ? encoder_velocity_pll() : encoder_velocity_mt();
+}
+
+float encoder_position(void) {
+    return (float)position * RAD_PER_COUNT;
+}
+
+void encoder_set_mode(EncoderMode new_mode) {
+    mode = new_mode;
+}
+
+// Resets the estimators to standstill at the given counter value
+static void encoder_reset(uint16_t count, float pll_bandwidth_hz) {
+    float wn_ts = 2.0f * (float)M_PI * pll_bandwidth_hz / (float)ENC_UPDATE_RATE_HZ;
+    pll_kp = (int32_t)(2.0f * wn_ts * 65536.0f); // zeta = 1
+    pll_ki = (int32_t)(wn_ts * wn_ts * 65536.0f);
+
+    prev_count = count;
+    position = 0;
+    mt_valid = false;
+    mt_edge_position = 0;
+    mt_velocity = 0.0f;
+    pll_position = 0;
+    pll_velocity = 0;
+}
+
+#ifndef HOST_SIM
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim2; // Encoder mode counter
+extern TIM_HandleTypeDef htim5; // Free-running edge timestamp (CH1 = A xor B, both edges)
+
+static uint32_t tick_decim = 0;
+
+void encoder_init(float pll_bandwidth_hz) {
+    HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_ALL);
+    HAL_TIM_IC_Start(&htim5, TIM_CHANNEL_1);
+    encoder_reset((uint16_t)__HAL_TIM_GET_COUNTER(&htim2), pll_bandwidth_hz);
+}
+
+void encoder_tick(void) {
+    if (++tick_decim < ENC_UPDATE_DECIM) return;
+    tick_decim = 0;
+
+    // Count and timestamp must belong to the same edge: re-read if an edge slipped in between
+    uint32_t edge_time = HAL_TIM_ReadCapturedValue(&htim5, TIM_CHANNEL_1);
+    uint16_t count = (uint16_t)__HAL_TIM_GET_COUNTER(&htim2);
+    uint32_t check = HAL_TIM_ReadCapturedValue(&htim5, TIM_CHANNEL_1);
+    if (check != edge_time) {
+        edge_time = check;
+        count = (uint16_t)__HAL_TIM_GET_COUNTER(&htim2);
+    }
+    encoder_process(count, edge_time, __HAL_TIM_GET_COUNTER(&htim5));
+}
+
+#else // HOST_SIM
+
+void encoder_init(float pll_bandwidth_hz) {
+    encoder_reset(0, pll_bandwidth_hz);
+}
+
+void encoder_tick(void) {
+    // Host drives encoder_process() directly
+}
+
+#endif // HOST_SIM
@@ -0,0 +1,79 @@
+#ifndef INC_MOTOR_ENCODER_H_
+#define INC_MOTOR_ENCODER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "motor_adc.h" // PWM_FREQ_HZ
+
+// --- Encoder Configuration ---
+// TIM2 counts quadrature edges (encoder mode, x4). TIM5 runs free at ENC_CAPTURE_CLK_HZ with
+// TI1S = 1 (CH1 = A xor B) and captures on both edges, so every count gets a timestamp.
+#define ENCODER_CPR 2048U                                  // Counts per revolution (x4)
+#define ENC_CAPTURE_CLK_HZ 84000000U                       // TIM5 counter clock (Hz)
+#define ENC_UPDATE_DECIM 10U                               // PWM periods per velocity update
+#define ENC_UPDATE_RATE_HZ (PWM_FREQ_HZ / ENC_UPDATE_DECIM) // 2 kHz
+#define ENC_STOP_TIMEOUT_S 0.1f                            // No edge for this long -> velocity is zero
+#define ENC_PLL_BANDWIDTH_HZ 100.0f                        // Default PLL natural frequency
+
+// --- Velocity Sources ---
+typedef enum {
+    ENC_MODE_MT,  // M/T: counts over the exact time between their first and last edge
+    ENC_MODE_PLL  // Tracking PLL on the count, smoother, lags by ~1/bandwidth
+} EncoderMode;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Starts the encoder and capture timers and resets both estimators.
+ * @param pll_bandwidth_hz PLL natural frequency (critically damped).
+ */
+void encoder_init(float pll_bandwidth_hz);
+
+/**
+ * @brief Selects the estimate returned by encoder_velocity().
+ */
+void encoder_set_mode(EncoderMode mode);
+
+/**
+ * @brief Reads the timers and updates both estimators every ENC_UPDATE_DECIM PWM periods.
+ * @note Call from the TIM1 update interrupt, before anything that reads the velocity.
+ */
+void encoder_tick(void);
+
+/**
+ * @brief One estimator update from raw timer values (hardware independent).
+ * @note Fixed cost per call: M/T takes one float divide, the PLL two float multiplies
+ *       for its sub-count input and two 32x32->64 multiplies.
+ * @param count Encoder counter (TIM2 CNT, 16 bit wrap).
+ * @param edge_time Capture timer value at the most recent count edge (TIM5 CCR1).
+ * @param now Capture timer value at this update (TIM5 CNT).
+ */
+void encoder_process(uint16_t count, uint32_t edge_time, uint32_t now);
+
+/**
+ * @brief Latest velocity from the selected source (rad/s).
+ */
+float encoder_velocity(void);
+
+/**
+ * @brief Latest M/T velocity (rad/s).
+ */
+float encoder_velocity_mt(void);
+
+/**
+ * @brief Latest PLL velocity (rad/s).
+ */
+float encoder_velocity_pll(void);
+
+/**
+ * @brief Latest PLL velocity, raw: Q16 counts per update (for integer-only ISRs).
+ * @note rad/s = value * 2*pi / ENCODER_CPR * ENC_UPDATE_RATE_HZ / 65536.
+ */
+int32_t encoder_velocity_pll_q16(void);
+
+/**
+ * @brief Accumulated shaft position since encoder_init() (rad).
+ */
+float encoder_position(void);
+
+#endif /* INC_MOTOR_ENCODER_H_ */
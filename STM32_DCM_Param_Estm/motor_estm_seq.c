@@ -0,0 +1,394 @@
+#include "motor_estm_seq.h"
+#include <math.h>
+#include "motor_params_rl.h"
+#include "motor_params_jb.h"
+#include "motor_lockin.h"
+#include "motor_adc.h"
+#include "motor_params_mech.h"
+#include "motor_params_friction.h"
+#include "motor_capture.h"
+#include "motor_log.h"
+
+// --- Sequencer State ---
+static EstmSeqConfig cfg;
+static EstmSeqState state = SEQ_IDLE;
+static uint32_t step_ticks = 0;    // Ticks spent in the current state
+static uint32_t seq_start_tick = 0; // HAL tick at estm_seq_start()
+static SteadyDetector det_a;       // Current (R) / velocity (Ke, sweep, J stop)
+static SteadyDetector det_b;       // Current (Ke, sweep)
+static uint32_t j_step_samples = 0; // Captured samples of the current step segment
+static uint32_t j_coast_samples = 0; // Captured samples of the coast-down segment
+static bool j_fit_coast = false;   // Coast-down segment still to be added to j_fit
+static MechFit j_fit;              // J/B/Tc fit, accumulated over several ticks
+static FrictionFit f_fit;          // Friction map fit, run over several ticks
+static FrictionData f_data;        // Steady points of the friction sweep
+static uint8_t f_point = 0;        // Current sweep speed, 0 .. 2 * f_points - 1
+static uint32_t f_ticks = 0;       // Ticks since the sweep started (velocity capture index)
+
+// --- Steady-State Detector ---
+
+void steady_reset(SteadyDetector *d) {
+    d->idx = 0;
+    d->count = 0;
+}
+
+void steady_add(SteadyDetector *d, float x) {
+    d->buf[d->idx] = x;
+    d->idx = (uint8_t)((d->idx + 1U) % STEADY_WINDOW);
+    if (d->count < STEADY_WINDOW) d->count++;
+}
+
+float steady_mean(const SteadyDetector *d) {
+    float sum = 0.0f;
+    if (d->count == 0) return 0.0f;
+    for (uint8_t i = 0; i < d->count; i++) sum += d->buf[i];
+    return sum / d->count;
+}
+
+bool steady_check(const SteadyDetector *d, float abs_tol, float rel_tol) {
+    if (d->count < STEADY_WINDOW) return false; // Window not full yet
+    float mean = steady_mean(d);
+    float var = 0.0f;
+    for (uint8_t i = 0; i < STEADY_WINDOW; i++) {
+        float e = d->buf[i] - mean;
+        var += e * e;
+    }
+    var /= STEADY_WINDOW;
+    float tol = fmaxf(abs_tol, rel_tol * fabsf(mean));
+    return var < tol * tol;
+}
+
+// --- Internal Helper Functions ---
+
+// Mean current of all samples that arrived since the last call (never waits)
+static bool sample_current(float *current) {
+    uint16_t block[32];
+    uint32_t sum = 0;
+    uint32_t n = 0;
+    uint32_t got;
+    while ((got = adc_stream_read(block, 32)) > 0) {
+        for (uint32_t i = 0; i < got; i++) sum += block[i];
+        n += got;
+    }
+    if (n == 0) return false;
+    *current = ((float)sum / (float)n - ADC_CURRENT_OFFSET) * V_REF / ADC_RESOLUTION / SHUNT_RESISTOR;
+    return true;
+}
+
+static void enter(EstmSeqState next) {
+    state = next;
+    step_ticks = 0;
+    steady_reset(&det_a);
+    steady_reset(&det_b);
+}
+
+static void fail(const char *why) {
+    capture_phase_end(false, NULL);
+    mech_capture_stop();
+    set_Vs(0.0f);
+    DC_Ctl_Velo(0.0f);
+    lockin_abort();
+    chirp_abort();
+    DEBUG_PRINTF("Estimation sequence failed: %s\n", why);
+    enter(SEQ_FAILED);
+}
+
+static bool timed_out(void) {
+    return step_ticks * ESTM_SEQ_TICK_MS > STEADY_TIMEOUT_MS;
+}
+
+// Commanded velocity of sweep point k: positive speeds high to low, then negative
+static float sweep_velocity(uint8_t k) {
+    uint8_t i = (uint8_t)(k % cfg.f_points);
+    float w = friction_sweep_velocity(i, cfg.f_points, cfg.f_min_velocity, cfg.f_max_velocity);
+    return (k < cfg.f_points) ? w : -w;
+}
+
+// Moves to the next sweep speed, or starts fitting the map after the last one
+static void sweep_next(void) {
+    if (++f_point < 2U * cfg.f_points) {
+        enter(SEQ_F_SWEEP);
+        DC_Ctl_Velo(sweep_velocity(f_point));
+        return;
+    }
+
+    // The shaft coasts down for the J step while the map is fitted
+    enter(SEQ_F_FIT);
+    DC_Ctl_Velo(0.0f);
+    friction_fit_start(&f_fit, &f_data);
+}
+
+// Loads the fitted map and moves on to J
+static void sweep_done(const FrictionModel *model) {
+    friction_map_load(model);
+    motor_B = 0.5f * (model->B[0] + model->B[1]);
+    motor_Tc = 0.5f * (model->Tc[0] + model->Tc[1]);
+    float Ts = 0.5f * (model->Ts[0] + model->Ts[1]);
+    DEBUG_PRINTF("Friction map from %u points: Tc %.5f/%.5f Nm, Ts %.5f/%.5f Nm, ws %.3f rad/s, "
+                 "B %.6f/%.6f Nm/(rad/s) (rms %.5f Nm)\n", f_data.n, model->Tc[0], model->Tc[1],
+                 model->Ts[0], model->Ts[1], model->ws, model->B[0], model->B[1], model->rms);
+    float results[4] = { motor_Tc, Ts, model->ws, motor_B };
+    capture_phase_end(true, results);
+    enter(SEQ_J_STOP);
+}
+
+// --- Public Functions ---
+
+void estm_seq_start(const EstmSeqConfig *config) {
+    cfg = *config;
+    if (cfg.f_points < 2U) cfg.f_points = 2U;
+    if (cfg.f_points > FRICTION_SWEEP_MAX) cfg.f_points = FRICTION_SWEEP_MAX;
+    seq_start_tick = HAL_GetTick();
+    DEBUG_PRINTF("\n*** PHASE 1: R/L Estimation (LOCK MOTOR SHAFT!) ***\n");
+    enter(SEQ_WAIT_LOCK);
+}
+
+void estm_seq_abort(void) {
+    if (estm_seq_busy()) fail("aborted");
+}
+
+bool estm_seq_busy(void) {
+    return state != SEQ_IDLE && state != SEQ_DONE && state != SEQ_FAILED;
+}
+
+EstmSeqState estm_seq_tick(void) {
+    float current, velocity;
+    LockinResult z;
+
+    step_ticks++;
+    switch (state) {
+    case SEQ_WAIT_LOCK:
+        if (step_ticks * ESTM_SEQ_TICK_MS >= cfg.operator_wait_ms) {
+            DEBUG_PRINTF("Estimating R (Shaft LOCKED!). Applying %.2fV...\n", cfg.r_voltage);
+            enter(SEQ_R_SETTLE);
+            float params[4] = { cfg.r_voltage };
+            capture_phase_begin(CAP_PHASE_R, params);
+            adc_stream_flush();
+            set_Vs(cfg.r_voltage);
+        }
+        break;
+
+    case SEQ_R_SETTLE:
+        // Current has settled once it stops moving: typically a few L/R, not a fixed second
+        if (sample_current(&current)) steady_add(&det_a, current);
+        if (steady_check(&det_a, 0.005f, 0.005f)) {
+            float steady_current = steady_mean(&det_a);
+            set_Vs(0.0f);
+            DEBUG_PRINTF("R: current settled after %lu ms\n", (unsigned long)(step_ticks * ESTM_SEQ_TICK_MS));
+            if (!estm_R_from_steady(cfg.r_voltage, steady_current)) { fail("R: current too low"); break; }
+            capture_phase_end(true, &motor_R);
+            enter(SEQ_L_LOCKIN);
+            float params[4] = { cfg.l_amplitude, cfg.l_frequency_hz, (float)cfg.l_cycles };
+            capture_phase_begin(CAP_PHASE_L_LOCKIN, params);
+            if (!lockin_start(cfg.l_amplitude, cfg.l_frequency_hz, cfg.l_cycles)) fail("L: invalid lock-in parameters");
+        } else if (timed_out()) {
+            fail("R: current did not settle");
+        }
+        break;
+
+    case SEQ_L_LOCKIN:
+        switch (lockin_poll(&z)) {
+        case LOCKIN_BUSY:
+            break;
+        case LOCKIN_DONE:
+            DEBUG_PRINTF("Z = %.4f %+.4fj Ohms at %.1f Hz\n", z.z_re, z.z_im, z.frequency_hz);
+            if (!estm_L_from_reactance(z.z_im, z.frequency_hz)) { fail("L: non-inductive reactance"); break; }
+            float results[4] = { motor_L, z.z_re, z.z_im, z.frequency_hz };
+            capture_phase_end(true, results);
+            DEBUG_PRINTF("\n*** PHASE 2: Ke/B/J Estimation (UNLOCK MOTOR SHAFT!) ***\n");
+            enter(SEQ_WAIT_UNLOCK);
+            break;
+        default:
+            fail("L: lock-in measurement failed");
+            break;
+        }
+        break;
+
+    case SEQ_WAIT_UNLOCK:
+        if (step_ticks * ESTM_SEQ_TICK_MS >= cfg.operator_wait_ms) {
+            DEBUG_PRINTF("Estimating Ke/Kt (Shaft UNLOCKED!). Commanding %.2f rad/s...\n", cfg.ke_velocity);
+            enter(SEQ_KE_SETTLE);
+            float params[4] = { cfg.ke_velocity, motor_R };
+            capture_phase_begin(CAP_PHASE_KE, params);
+            adc_stream_flush();
+            DC_Ctl_Velo(cfg.ke_velocity);
+        }
+        break;
+
+    case SEQ_KE_SETTLE:
+        velocity = read_velo();
+        steady_add(&det_a, velocity);
+        capture_velocity_sample(step_ticks, 1000U / ESTM_SEQ_TICK_MS, velocity);
+        if (sample_current(&current)) steady_add(&det_b, current);
+        if (steady_check(&det_a, 0.05f, 0.01f) && steady_check(&det_b, 0.005f, 0.02f)) {
+            float steady_velocity = steady_mean(&det_a);
+            float steady_current = steady_mean(&det_b);
+            float steady_voltage = read_Vs();
+            DEBUG_PRINTF("Ke: speed settled after %lu ms\n", (unsigned long)(step_ticks * ESTM_SEQ_TICK_MS));
+            if (!estm_Ke_from_steady(steady_voltage, steady_current, steady_velocity)) {
+                fail("Ke: velocity too low");
+                break;
+            }
+            float results[4] = { motor_Ke, steady_voltage, steady_current, steady_velocity };
+            capture_phase_end(true, results);
+
+            // Straight into the sweep, no stop in between
+            DEBUG_PRINTF("Estimating friction map. Sweeping %.2f .. %.2f rad/s, both directions...\n",
+                         cfg.f_min_velocity, cfg.f_max_velocity);
+            enter(SEQ_F_SWEEP);
+            f_point = 0;
+            f_ticks = 0;
+            friction_data_reset(&f_data);
+            float params[4] = { cfg.f_min_velocity, cfg.f_max_velocity, (float)cfg.f_points, motor_Kt };
+            capture_phase_begin(CAP_PHASE_FRICTION, params);
+            DC_Ctl_Velo(sweep_velocity(0));
+        } else if (timed_out()) {
+            fail("Ke: velocity or current did not settle");
+        }
+        break;
+
+    case SEQ_F_SWEEP:
+        velocity = read_velo();
+        steady_add(&det_a, velocity);
+        capture_velocity_sample(f_ticks++, 1000U / ESTM_SEQ_TICK_MS, velocity);
+        if (sample_current(&current)) steady_add(&det_b, current);
+        if (steady_check(&det_a, 0.05f, 0.01f) && steady_check(&det_b, 0.005f, 0.02f)) {
+            float steady_velocity = steady_mean(&det_a);
+            float steady_current = steady_mean(&det_b);
+            // At steady state the motor torque balances friction; its sign follows the motion
+            if (steady_velocity * sweep_velocity(f_point) > 0.0f && fabsf(steady_velocity) > 0.01f) {
+                float torque = estm_steady_torque(steady_current);
+                friction_data_add(&f_data, steady_velocity, (steady_velocity > 0.0f) ? torque : -torque);
+                capture_point(steady_velocity, steady_current);
+            }
+            sweep_next();
+        } else if (timed_out()) {
+            // One unreachable speed (e.g. below the stick-slip limit) only costs its point
+            DEBUG_PRINTF("Friction: no steady state at %.2f rad/s, skipped\n", sweep_velocity(f_point));
+            sweep_next();
+        }
+        break;
+
+    case SEQ_F_FIT: {
+        FrictionModel model;
+        switch (friction_fit_step(&f_fit, F_FIT_POINTS_PER_TICK, &model)) {
+        case FRICTION_FIT_BUSY:
+            break;
+        case FRICTION_FIT_DONE:
+            sweep_done(&model);
+            break;
+        default:
+            fail("Friction: fit failed (too few steady points)");
+            break;
+        }
+        break;
+    }
+
+    case SEQ_J_STOP:
+        velocity = read_velo();
+        steady_add(&det_a, velocity);
+        if (fabsf(velocity) < STOP_VELOCITY && steady_check(&det_a, 0.05f, 0.0f)) {
+            DEBUG_PRINTF("Estimating J/B/Tc. Applying %.2f A current step...\n", cfg.j_current);
+            enter(SEQ_J_STEP);
+            mech_capture_start(0, MECH_STEP_SAMPLES, 0.0f);
+            DCM_Ctl_Curr(cfg.j_current); // Apply current step -> torque step
+        } else if (timed_out()) {
+            fail("J: shaft did not stop");
+        }
+        break;
+
+    case SEQ_J_STEP:
+        if (!mech_capture_done()) {
+            if (timed_out()) fail("J: velocity capture stalled");
+            break;
+        }
+        j_step_samples = mech_capture_count();
+        enter(SEQ_J_COAST);
+        DCM_Ctl_Curr(0.0f); // Zero torque, shaft coasts
+        mech_capture_start(j_step_samples, MECH_CAPTURE_LEN - j_step_samples, MECH_STOP_VELOCITY);
+        break;
+
+    case SEQ_J_COAST: {
+        if (!mech_capture_done()) {
+            if (timed_out()) fail("J: velocity capture stalled");
+            break;
+        }
+        DC_Ctl_Velo(0.0f); // Command zero velocity for safety
+        j_coast_samples = mech_capture_count();
+
+        // Least-squares fit of the whole w(t) curve instead of two end points, in SEQ_J_FIT
+        const float *w = mech_capture_buffer();
+        float params[4] = { cfg.j_current, motor_Kt, (float)j_step_samples };
+        capture_phase_begin(CAP_PHASE_J, params);
+        capture_velocity(0, MECH_CAPTURE_RATE_HZ, w, j_step_samples + j_coast_samples);
+        mech_fit_reset(&j_fit);
+        mech_fit_begin_segment(&j_fit, w, j_step_samples, MECH_CAPTURE_PERIOD_S, motor_Kt * cfg.j_current);
+        j_fit_coast = true;
+        enter(SEQ_J_FIT);
+        break;
+    }
+
+    case SEQ_J_FIT: {
+        if (!mech_fit_step(&j_fit, J_FIT_ROWS_PER_TICK)) break;
+        if (j_fit_coast) {
+            j_fit_coast = false;
+            const float *w = mech_capture_buffer() + j_step_samples;
+            if (mech_fit_begin_segment(&j_fit, w, j_coast_samples, MECH_CAPTURE_PERIOD_S, 0.0f)) break;
+        }
+        MechFitResult res;
+        if (!estm_J_from_fit(&j_fit, &res)) {
+            fail("J: fit failed (too little motion)");
+            break;
+        }
+        float results[4] = { res.J, res.B, res.Tc, res.rms };
+        capture_phase_end(true, results);
+
+        // The chirp only feeds the host-side fit: skipped without a capture to record it in
+        if (cfg.chirp_amplitude > 0.0f && capture_enabled()) {
+            DEBUG_PRINTF("Recording chirp: %.2f V, %.2f .. %.1f Hz in %.1f s...\n", cfg.chirp_amplitude,
+                         cfg.chirp_f_start_hz, cfg.chirp_f_end_hz, cfg.chirp_duration_s);
+            enter(SEQ_CHIRP);
+            float chirp_params[4] = { cfg.chirp_amplitude, cfg.chirp_f_start_hz, cfg.chirp_f_end_hz,
+                                      cfg.chirp_duration_s };
+            capture_phase_begin(CAP_PHASE_CHIRP, chirp_params);
+            if (!chirp_start(cfg.chirp_amplitude, cfg.chirp_f_start_hz, cfg.chirp_f_end_hz, cfg.chirp_duration_s)) {
+                fail("Chirp: invalid parameters");
+            }
+            break;
+        }
+        DEBUG_PRINTF("Estimation sequence complete in %lu ms\n", (unsigned long)(HAL_GetTick() - seq_start_tick));
+        enter(SEQ_DONE);
+        break;
+    }
+
+    case SEQ_CHIRP: {
+        ChirpResult chirp;
+        switch (chirp_poll(&chirp)) {
+        case LOCKIN_BUSY:
+            if (step_ticks * ESTM_SEQ_TICK_MS > (uint32_t)(cfg.chirp_duration_s * 1000.0f) + STEADY_TIMEOUT_MS) {
+                fail("Chirp: sample stream stalled");
+            }
+            break;
+        case LOCKIN_DONE: {
+            // Exact integers (< 2^24) so the host regenerates the applied voltage bit for bit
+            float results[4] = { (float)chirp.growth, (float)chirp.samples, (float)chirp.amp,
+                                 (float)chirp.velocity_lost };
+            capture_phase_end(true, results);
+            DEBUG_PRINTF("Chirp recorded (%lu samples, %lu velocity samples lost)\n",
+                         (unsigned long)chirp.samples, (unsigned long)chirp.velocity_lost);
+            DEBUG_PRINTF("Estimation sequence complete in %lu ms\n", (unsigned long)(HAL_GetTick() - seq_start_tick));
+            enter(SEQ_DONE);
+            break;
+        }
+        default:
+            fail("Chirp: sample stream overrun");
+            break;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+    return state;
+}
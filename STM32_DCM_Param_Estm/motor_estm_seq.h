@@ -0,0 +1,96 @@
+#ifndef INC_MOTOR_ESTM_SEQ_H_
+#define INC_MOTOR_ESTM_SEQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Sequencer Configuration ---
+#define ESTM_SEQ_TICK_MS 1U          // estm_seq_tick() period
+#define STEADY_WINDOW 50U            // Samples in the steady-state window (50 ms at 1 ms ticks)
+#define STEADY_TIMEOUT_MS 5000U      // Longest wait for any steady state before the step fails
+#define STOP_VELOCITY 0.2f           // |w| below which the shaft counts as stopped (rad/s)
+// The offline fits run a bounded slice per tick so a tick stays within the estimation task's
+// budget (main.c); worst cases at 168 MHz with soft-float double, estimated from op counts
+#define F_FIT_POINTS_PER_TICK 4U     // Friction fit: ~30 us per point (double exp), ~130 us per solve step
+#define J_FIT_ROWS_PER_TICK 8U       // J/B/Tc fit: ~20 us per row, 1024 rows in ~130 ticks
+
+// --- Sequencer States ---
+typedef enum {
+    SEQ_IDLE,
+    SEQ_WAIT_LOCK,    // Operator locks the shaft
+    SEQ_R_SETTLE,     // Voltage applied, waiting for steady current
+    SEQ_L_LOCKIN,     // Lock-in inductance measurement
+    SEQ_WAIT_UNLOCK,  // Operator unlocks the shaft
+    SEQ_KE_SETTLE,    // Velocity commanded, waiting for steady velocity and current
+    SEQ_F_SWEEP,      // Friction map: steady velocity and current at each sweep speed
+    SEQ_F_FIT,        // Friction map fit, F_FIT_POINTS_PER_TICK at a time, while the shaft stops
+    SEQ_J_STOP,       // Waiting for the shaft to stop
+    SEQ_J_STEP,       // Current step applied, capturing velocity
+    SEQ_J_COAST,      // Free coast-down, capturing velocity
+    SEQ_J_FIT,        // J/B/Tc fit of the capture, J_FIT_ROWS_PER_TICK at a time
+    SEQ_CHIRP,        // Voltage chirp recorded for the host-side model fit (host/dcm_fit)
+    SEQ_DONE,
+    SEQ_FAILED
+} EstmSeqState;
+
+// --- Test Parameters ---
+typedef struct {
+    float r_voltage;          // Voltage for R (V)
+    float l_amplitude;        // Lock-in sine amplitude for L (V)
+    float l_frequency_hz;     // Lock-in frequency (Hz)
+    uint32_t l_cycles;        // Lock-in cycles
+    float ke_velocity;        // Velocity for Ke (rad/s)
+    float f_min_velocity;     // Slowest friction sweep speed (rad/s)
+    float f_max_velocity;     // Fastest friction sweep speed (rad/s)
+    uint8_t f_points;         // Sweep speeds per direction (<= FRICTION_SWEEP_MAX)
+    float j_current;          // Current step for J (A)
+    float chirp_amplitude;    // Chirp voltage amplitude (V), 0 skips the chirp
+    float chirp_f_start_hz;   // Chirp start frequency (Hz)
+    float chirp_f_end_hz;     // Chirp end frequency (Hz)
+    float chirp_duration_s;   // Chirp duration (s)
+    uint32_t operator_wait_ms; // Time given to lock/unlock the shaft
+} EstmSeqConfig;
+
+// --- Steady-State Detector ---
+// Windowed mean/variance; steady when the standard deviation over the last
+// STEADY_WINDOW samples is below max(abs_tol, rel_tol * |mean|)
+typedef struct {
+    float buf[STEADY_WINDOW];
+    uint8_t idx;
+    uint8_t count;
+} SteadyDetector;
+
+// --- Public Function Prototypes ---
+
+void steady_reset(SteadyDetector *d);
+void steady_add(SteadyDetector *d, float x);
+bool steady_check(const SteadyDetector *d, float abs_tol, float rel_tol);
+float steady_mean(const SteadyDetector *d);
+
+/**
+ * @brief Starts the full estimation sequence (R, L locked; Ke, friction map, J unlocked).
+ * @note With the raw capture running and chirp_amplitude set, a voltage chirp is recorded
+ *       last; host/dcm_fit fits R, L, Ke, J, B and Tc jointly to it.
+ * @note Returns immediately; the sequence advances in estm_seq_tick().
+ */
+void estm_seq_start(const EstmSeqConfig *cfg);
+
+/**
+ * @brief Advances the sequence; call every ESTM_SEQ_TICK_MS from the main loop.
+ * @note Never blocks. Each step ends as soon as its steady-state detector fires
+ *       or fails after STEADY_TIMEOUT_MS; results go to the motor_* globals.
+ * @return State after the tick.
+ */
+EstmSeqState estm_seq_tick(void);
+
+/**
+ * @brief Stops the sequence and the motor.
+ */
+void estm_seq_abort(void);
+
+/**
+ * @brief True while the sequence is running.
+ */
+bool estm_seq_busy(void);
+
+#endif /* INC_MOTOR_ESTM_SEQ_H_ */
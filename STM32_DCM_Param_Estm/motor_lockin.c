@@ -0,0 +1,414 @@
+#include "motor_lockin.h"
+#include <math.h>
+#include "motor_params_rl.h" // htim1, V_SUPPLY
+#include "motor_adc.h"
+#include "motor_current_loop.h" // Released while the generator owns the compare
+#include "motor_bridge.h"       // Signed H-bridge output
+#include "motor_encoder.h"      // Velocity latched during a chirp
+#include "motor_capture.h"      // Chirp samples go to the raw capture
+
+// --- Internal State ---
+static int16_t sine_table[LOCKIN_TABLE_SIZE]; // Q15 sine, one full period
+static bool table_ready = false;
+
+// Excitation generator, owned by the TIM1 update ISR while active
+typedef enum {
+    EXCITE_OFF,
+    EXCITE_SINE,       // Phase accumulator into sine_table
+    EXCITE_MULTISINE,  // Periodic playback of multisine_ccr
+    EXCITE_CHIRP       // Phase accumulator with a geometrically growing step
+} ExciteMode;
+
+static volatile ExciteMode excite_mode = EXCITE_OFF;
+static uint32_t excite_phase = 0;  // Phase accumulator (full turn = 2^32) / multisine sample counter
+static uint32_t excite_step = 0;   // Phase increment per PWM period
+static uint32_t excite_mid = 0;    // Compare value of the DC offset
+static int32_t excite_amp = 0;     // Compare value of the sine amplitude
+static uint16_t multisine_ccr[MULTISINE_PERIOD]; // One precomputed multisine period (compare values)
+static int16_t multisine_ref[MULTISINE_PERIOD];   // Q15 sine at the multisine phase resolution
+static uint64_t chirp_step = 0;    // Phase step with CHIRP_STEP_FRAC_BITS extra fraction bits
+static uint32_t chirp_growth = 0;  // Step growth per sample (Q32)
+static volatile uint32_t chirp_left = 0; // Samples still to play
+static uint32_t chirp_decim = 0;
+static float chirp_velocity[CHIRP_VELOCITY_RING]; // Latched by the ISR, drained by chirp_poll()
+static volatile uint32_t chirp_velocity_head = 0;
+
+#define PHASE_TO_INDEX(p) ((p) >> (32U - LOCKIN_TABLE_BITS))
+#define QUARTER_TURN (LOCKIN_TABLE_SIZE / 4U)
+#define TABLE_MASK (LOCKIN_TABLE_SIZE - 1U)
+
+void lockin_init(void) {
+    for (uint32_t i = 0; i < LOCKIN_TABLE_SIZE; i++) {
+        sine_table[i] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * (float)i / LOCKIN_TABLE_SIZE));
+    }
+    // Full MULTISINE_PERIOD resolution: tone phases h * n / MULTISINE_PERIOD land on an entry
+    // exactly, so the reference matches the excitation for every harmonic
+    for (uint32_t n = 0; n < MULTISINE_PERIOD; n++) {
+        multisine_ref[n] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * (float)n / MULTISINE_PERIOD));
+    }
+    table_ready = true;
+}
+
+void lockin_pwm_update(void) {
+    if (excite_mode == EXCITE_SINE) {
+        int32_t s = sine_table[PHASE_TO_INDEX(excite_phase)];
+        bridge_write((int32_t)excite_mid + ((excite_amp * s) >> 15));
+        excite_phase += excite_step;
+    } else if (excite_mode == EXCITE_MULTISINE) {
+        bridge_write(multisine_ccr[excite_phase & (MULTISINE_PERIOD - 1U)]);
+        excite_phase++;
+    } else if (excite_mode == EXCITE_CHIRP) {
+        if (chirp_decim++ % CHIRP_VELOCITY_DECIM == 0U) {
+            chirp_velocity[chirp_velocity_head % CHIRP_VELOCITY_RING] = encoder_velocity();
+            chirp_velocity_head++;
+        }
+        if (chirp_left == 0U) { // Sweep played: hold 0 V, keep latching the velocity until stopped
+            bridge_write(0);
+            return;
+        }
+        int32_t s = sine_table[PHASE_TO_INDEX(excite_phase)];
+        bridge_write((excite_amp * s) >> 15);
+        uint32_t step = (uint32_t)(chirp_step >> CHIRP_STEP_FRAC_BITS);
+        excite_phase += step;
+        chirp_step += ((uint64_t)step * chirp_growth) >> CHIRP_STEP_FRAC_BITS; // 32x32 -> 64 multiply
+        chirp_left--;
+    }
+}
+
+// Starts the generator and the sample stream on the same PWM period
+static void excite_start(ExciteMode mode) {
+    current_loop_disable();
+    __disable_irq();
+    excite_phase = 0;
+    adc_stream_flush();
+    excite_mode = mode;
+    __enable_irq();
+}
+
+static void excite_stop(void) {
+    excite_mode = EXCITE_OFF;
+    bridge_write(0);
+}
+
+// Converts correlator sums to the current phasor in the frame of the applied voltage
+// i(t) = i_s*sin + i_c*cos; the voltage reached the winding delay_rad later than the reference
+static void correlator_phasor(int64_t acc_sin, int64_t acc_cos, uint32_t n, float delay_rad,
+                              float *i_re, float *i_im) {
+    float amps_per_count = V_REF / ADC_RESOLUTION / SHUNT_RESISTOR;
+    float i_s = 2.0f * (float)acc_sin / (32767.0f * (float)n) * amps_per_count;
+    float i_c = 2.0f * (float)acc_cos / (32767.0f * (float)n) * amps_per_count;
+    float cd = cosf(delay_rad);
+    float sd = sinf(delay_rad);
+    *i_re = i_s * cd - i_c * sd;
+    *i_im = i_s * sd + i_c * cd;
+}
+
+// Single-tone measurement in progress (resumable through lockin_poll())
+static struct {
+    bool busy;
+    uint32_t step;      // Phase step per sample
+    uint32_t amp;       // Compare value of amplitude and offset
+    uint32_t settle;    // Samples skipped before correlating
+    uint32_t n;         // Samples correlated
+    uint32_t k;         // Samples consumed so far
+    uint32_t phase;     // Reference phase of sample k
+    int64_t acc_sin;
+    int64_t acc_cos;
+    uint32_t acc_dc;
+} lk;
+
+bool lockin_start(float amplitude_V, float frequency_hz, uint32_t cycles) {
+    if (lk.busy) return false;
+    if (amplitude_V <= 0.0f || 2.0f * amplitude_V > V_SUPPLY) return false;
+    if (frequency_hz <= 0.0f || frequency_hz > ADC_SAMPLE_RATE_HZ / 4U || cycles == 0) return false;
+    if (!table_ready) lockin_init();
+
+    // Phase step and compare values, quantized once
+    uint32_t step = (uint32_t)(frequency_hz / ADC_SAMPLE_RATE_HZ * 4294967296.0f + 0.5f);
+    uint32_t samples_per_cycle = (uint32_t)(4294967296.0f / (float)step + 0.5f);
+    lk.step = step;
+    lk.amp = (uint32_t)(amplitude_V / V_SUPPLY * htim1.Instance->ARR + 0.5f);
+    lk.settle = LOCKIN_SETTLE_CYCLES * samples_per_cycle;
+    lk.n = (uint32_t)(((uint64_t)cycles << 32) / step); // Whole cycles only, rejects the DC offset
+    lk.k = 0;
+    lk.phase = 0;
+    lk.acc_sin = 0;
+    lk.acc_cos = 0;
+    lk.acc_dc = 0;
+    lk.busy = true;
+
+    excite_step = step;
+    excite_mid = lk.amp;
+    excite_amp = (int32_t)lk.amp;
+    excite_start(EXCITE_SINE);
+    return true;
+}
+
+LockinStatus lockin_poll(LockinResult *result) {
+    if (!lk.busy) return LOCKIN_FAILED;
+
+    // --- Single pass correlation over the samples available now ---
+    // Integer multiply-accumulate only: fixed time per sample
+    uint16_t block[32];
+    uint32_t got;
+    while (lk.k < lk.settle + lk.n) {
+        uint32_t want = lk.settle + lk.n - lk.k;
+        if (want > 32) want = 32;
+        got = adc_stream_read(block, want);
+        if (got == 0) return LOCKIN_BUSY;
+        for (uint32_t i = 0; i < got; i++, lk.k++, lk.phase += lk.step) {
+            if (lk.k < lk.settle) continue;
+            uint32_t idx = PHASE_TO_INDEX(lk.phase);
+            int32_t raw = (int32_t)block[i] - ADC_CURRENT_OFFSET; // Signed current
+            lk.acc_sin += raw * sine_table[idx];
+            lk.acc_cos += raw * sine_table[(idx + QUARTER_TURN) & TABLE_MASK];
+            lk.acc_dc += block[i];
+        }
+    }
+
+    excite_stop();
+    lk.busy = false;
+    if (adc_stream_overrun()) return LOCKIN_FAILED;
+
+    // --- Phasors ---
+    float i_re, i_im;
+    float delay = 2.0f * (float)M_PI * LOCKIN_DELAY_SAMPLES * (float)lk.step / 4294967296.0f;
+    correlator_phasor(lk.acc_sin, lk.acc_cos, lk.n, delay, &i_re, &i_im);
+    float i_mag2 = i_re * i_re + i_im * i_im;
+    if (i_mag2 < 1e-12f) return LOCKIN_FAILED;
+
+    float v = (float)lk.amp / htim1.Instance->ARR * V_SUPPLY;
+    result->frequency_hz = (float)lk.step * ADC_SAMPLE_RATE_HZ / 4294967296.0f;
+    result->amplitude_V = v;
+    result->i_dc = ((float)lk.acc_dc / (float)lk.n - ADC_CURRENT_OFFSET) * V_REF / ADC_RESOLUTION / SHUNT_RESISTOR;
+    result->i_re = i_re;
+    result->i_im = i_im;
+    result->z_re = v * i_re / i_mag2;  // Z = V / I with V real
+    result->z_im = -v * i_im / i_mag2;
+    result->samples = lk.n;
+    return LOCKIN_DONE;
+}
+
+void lockin_abort(void) {
+    if (!lk.busy) return;
+    excite_stop();
+    lk.busy = false;
+}
+
+bool lockin_measure(float amplitude_V, float frequency_hz, uint32_t cycles, LockinResult *result) {
+    if (!lockin_start(amplitude_V, frequency_hz, cycles)) return false;
+
+    uint32_t start = HAL_GetTick();
+    LockinStatus status;
+    while ((status = lockin_poll(result)) == LOCKIN_BUSY) {
+        if (HAL_GetTick() - start > 10000U) { // Samples stopped arriving
+            lockin_abort();
+            return false;
+        }
+    }
+    return status == LOCKIN_DONE;
+}
+
+// Sweep in progress (resumable through chirp_poll())
+static struct {
+    bool busy;
+    uint32_t n;         // Samples to play
+    uint32_t k;         // Current samples consumed so far
+    uint32_t vel_tail;  // Next velocity sample to read from the ring
+    ChirpResult result;
+} ch;
+
+bool chirp_start(float amplitude_V, float f_start_hz, float f_end_hz, float duration_s) {
+    if (ch.busy || lk.busy) return false;
+    if (amplitude_V <= 0.0f || amplitude_V > V_SUPPLY || duration_s <= 0.0f) return false;
+    if (f_start_hz <= 0.0f || f_end_hz <= f_start_hz || f_end_hz > ADC_SAMPLE_RATE_HZ / 4U) return false;
+    if (!table_ready) lockin_init();
+
+    // Constant growth per sample: f_end = f_start * (1 + growth)^n. expm1f keeps the
+    // growth exact where powf would round it to float steps around 1.
+    uint32_t n = (uint32_t)(duration_s * ADC_SAMPLE_RATE_HZ + 0.5f);
+    uint32_t step = (uint32_t)(f_start_hz / ADC_SAMPLE_RATE_HZ * 4294967296.0f + 0.5f);
+    float growth = expm1f(logf(f_end_hz / f_start_hz) / (float)n);
+    if (n == 0 || step == 0 || growth * 4294967296.0f >= 16777216.0f) return false; // Exact in a float record
+
+    ch.n = n;
+    ch.k = 0;
+    ch.vel_tail = 0;
+    ch.result.amp = (uint32_t)(amplitude_V / V_SUPPLY * htim1.Instance->ARR + 0.5f);
+    ch.result.growth = (uint32_t)(growth * 4294967296.0f + 0.5f);
+    ch.result.samples = n;
+    ch.result.f_end_hz = f_start_hz * expf((float)n * log1pf(ch.result.growth / 4294967296.0f));
+    ch.result.velocity_lost = 0;
+    ch.busy = true;
+
+    chirp_step = (uint64_t)step << CHIRP_STEP_FRAC_BITS;
+    chirp_growth = ch.result.growth;
+    chirp_left = n;
+    chirp_decim = 0;
+    chirp_velocity_head = 0;
+    excite_mid = 0;
+    excite_amp = (int32_t)ch.result.amp;
+    excite_start(EXCITE_CHIRP);
+    return true;
+}
+
+LockinStatus chirp_poll(ChirpResult *result) {
+    if (!ch.busy) return LOCKIN_FAILED;
+
+    // Current: reading is all it takes, adc_stream_read() hands the samples to the capture
+    uint16_t block[32];
+    uint32_t got;
+    while (ch.k < ch.n) {
+        uint32_t want = ch.n - ch.k;
+        got = adc_stream_read(block, want > 32U ? 32U : want);
+        if (got == 0) break;
+        ch.k += got;
+    }
+
+    // Velocity: samples the ISR has latched since the last poll
+    uint32_t head = chirp_velocity_head;
+    if (head - ch.vel_tail > CHIRP_VELOCITY_RING) {
+        ch.result.velocity_lost += head - ch.vel_tail - CHIRP_VELOCITY_RING;
+        ch.vel_tail = head - CHIRP_VELOCITY_RING;
+    }
+    for (; ch.vel_tail != head; ch.vel_tail++) {
+        capture_velocity_sample(ch.vel_tail, CHIRP_VELOCITY_RATE_HZ, chirp_velocity[ch.vel_tail % CHIRP_VELOCITY_RING]);
+    }
+    if (ch.k < ch.n) return LOCKIN_BUSY;
+
+    excite_stop();
+    ch.busy = false;
+    if (adc_stream_overrun()) return LOCKIN_FAILED;
+    *result = ch.result;
+    return LOCKIN_DONE;
+}
+
+void chirp_abort(void) {
+    if (!ch.busy) return;
+    excite_stop();
+    ch.busy = false;
+}
+
+// Least-squares line y = a + b*x
+static void fit_line(const float *x, const float *y, uint8_t n, float *a, float *b) {
+    float sx = 0.0f, sy = 0.0f, sxx = 0.0f, sxy = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+    float det = n * sxx - sx * sx;
+    *b = (det != 0.0f) ? (n * sxy - sx * sy) / det : 0.0f;
+    *a = (sy - *b * sx) / n;
+}
+
+bool multisine_measure(float amplitude_V, float f_min_hz, float f_max_hz, uint8_t tones,
+                       uint32_t periods, ImpedanceSpectrum *spectrum) {
+    const float f0 = (float)ADC_SAMPLE_RATE_HZ / MULTISINE_PERIOD; // Frequency resolution
+    uint32_t harmonic[MULTISINE_MAX_TONES];
+    float tone_phase[MULTISINE_MAX_TONES];
+
+    if (amplitude_V <= 0.0f || 2.0f * amplitude_V > V_SUPPLY || periods == 0) return false;
+    if (tones < 2 || tones > MULTISINE_MAX_TONES) return false;
+    if (f_min_hz <= 0.0f || f_max_hz <= f_min_hz || f_max_hz > ADC_SAMPLE_RATE_HZ / 8U) return false;
+    if (!table_ready) lockin_init();
+
+    // --- Log-spaced harmonics of f0 ---
+    uint32_t h_min = (uint32_t)ceilf(f_min_hz / f0);
+    uint32_t h_max = (uint32_t)(f_max_hz / f0);
+    if (h_min < 1) h_min = 1;
+    if (h_max <= h_min) return false;
+    uint8_t count = 0;
+    for (uint8_t k = 0; k < tones; k++) {
+        uint32_t h = (uint32_t)lrintf(h_min * powf((float)h_max / h_min, (float)k / (tones - 1)));
+        if (count > 0 && h <= harmonic[count - 1]) continue; // Coincides at low frequency
+        harmonic[count++] = h;
+    }
+
+    // --- Schroeder phases, scale to the requested peak ---
+    float peak = 0.0f;
+    float sum_sq = 0.0f;
+    for (uint8_t k = 0; k < count; k++) {
+        tone_phase[k] = -(float)M_PI * k * (k + 1) / count;
+    }
+    for (uint32_t n = 0; n < MULTISINE_PERIOD; n++) {
+        float v = 0.0f;
+        for (uint8_t k = 0; k < count; k++) {
+            v += sinf(2.0f * (float)M_PI * harmonic[k] * n / MULTISINE_PERIOD + tone_phase[k]);
+        }
+        if (fabsf(v) > peak) peak = fabsf(v);
+        sum_sq += v * v;
+    }
+    uint32_t arr = htim1.Instance->ARR;
+    float counts_per_volt = arr / V_SUPPLY;
+    float tone_V = amplitude_V / peak; // Amplitude of every tone
+    for (uint32_t n = 0; n < MULTISINE_PERIOD; n++) {
+        float v = 0.0f;
+        for (uint8_t k = 0; k < count; k++) {
+            v += sinf(2.0f * (float)M_PI * harmonic[k] * n / MULTISINE_PERIOD + tone_phase[k]);
+        }
+        multisine_ccr[n] = (uint16_t)lrintf((amplitude_V + tone_V * v) * counts_per_volt);
+    }
+
+    // --- Single pass correlation, one correlator per tone ---
+    // Tone k of sample n has phase h_k * n / MULTISINE_PERIOD turns: index (h_k * n) mod period
+    // of multisine_ref, the same phase the excitation was computed at
+    int64_t acc_sin[MULTISINE_MAX_TONES] = {0};
+    int64_t acc_cos[MULTISINE_MAX_TONES] = {0};
+    uint32_t phase[MULTISINE_MAX_TONES] = {0};
+    const uint32_t mask = MULTISINE_PERIOD - 1U;
+
+    uint32_t settle = LOCKIN_SETTLE_CYCLES * MULTISINE_PERIOD;
+    uint32_t total = settle + periods * MULTISINE_PERIOD;
+    uint16_t block[32];
+    uint32_t done = 0;
+    bool ok = true;
+
+    excite_start(EXCITE_MULTISINE);
+    while (done < total) {
+        if (!adc_stream_read_block(block, 32, 10)) { ok = false; break; } // MULTISINE_PERIOD is a multiple of 32
+        for (uint32_t i = 0; i < 32; i++, done++) {
+            int32_t raw = (int32_t)block[i] - ADC_CURRENT_OFFSET;
+            for (uint8_t k = 0; k < count; k++) {
+                uint32_t idx = phase[k];
+                phase[k] = (phase[k] + harmonic[k]) & mask;
+                if (done < settle) continue;
+                acc_sin[k] += raw * multisine_ref[idx];
+                acc_cos[k] += raw * multisine_ref[(idx + MULTISINE_PERIOD / 4U) & mask];
+            }
+        }
+    }
+    excite_stop();
+    if (!ok || adc_stream_overrun()) return false;
+
+    // --- Z(f) per tone ---
+    float f[MULTISINE_MAX_TONES];
+    float r[MULTISINE_MAX_TONES];
+    float l[MULTISINE_MAX_TONES];
+    uint32_t n = total - settle;
+    for (uint8_t k = 0; k < count; k++) {
+        float i_re, i_im;
+        float freq = harmonic[k] * f0;
+        float delay = 2.0f * (float)M_PI * LOCKIN_DELAY_SAMPLES * freq / ADC_SAMPLE_RATE_HZ;
+        // Voltage of tone k is tone_V * sin(theta + phi_k): rotate the current by -phi_k as well
+        correlator_phasor(acc_sin[k], acc_cos[k], n, delay - tone_phase[k], &i_re, &i_im);
+        float i_mag2 = i_re * i_re + i_im * i_im;
+        if (i_mag2 < 1e-12f) return false;
+
+        spectrum->point[k].frequency_hz = freq;
+        spectrum->point[k].z_re = tone_V * i_re / i_mag2;
+        spectrum->point[k].z_im = -tone_V * i_im / i_mag2;
+        f[k] = freq;
+        r[k] = spectrum->point[k].z_re;
+        l[k] = spectrum->point[k].z_im / (2.0f * (float)M_PI * freq);
+    }
+
+    // --- R(f), L(f) fit across frequency ---
+    spectrum->tones = count;
+    spectrum->crest_factor = peak / sqrtf(sum_sq / MULTISINE_PERIOD);
+    spectrum->samples = n;
+    fit_line(f, r, count, &spectrum->R0, &spectrum->R_slope);
+    fit_line(f, l, count, &spectrum->L0, &spectrum->L_slope);
+    return true;
+}
@@ -0,0 +1,169 @@
+#ifndef INC_MOTOR_LOCKIN_H_
+#define INC_MOTOR_LOCKIN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "motor_adc.h" // PWM_FREQ_HZ
+
+// --- Lock-in Configuration ---
+#define LOCKIN_TABLE_BITS 8                       // Sine table index width
+#define LOCKIN_TABLE_SIZE (1U << LOCKIN_TABLE_BITS)
+#define LOCKIN_SETTLE_CYCLES 2U                   // Excitation cycles discarded before correlating (DC step transient)
+// Samples between the phase the update ISR writes and the current sample it shows up in:
+// one period of compare preload plus half a period of zero-order hold
+#define LOCKIN_DELAY_SAMPLES 1.5f
+
+// --- Multisine Configuration ---
+#define MULTISINE_PERIOD_BITS 10                  // Samples per multisine period = 2^bits
+#define MULTISINE_PERIOD (1U << MULTISINE_PERIOD_BITS) // 1024 samples: 19.53 Hz resolution at 20 kHz
+#define MULTISINE_MAX_TONES 12                    // Correlators run per sample, one per tone
+
+// --- Chirp Configuration ---
+#define CHIRP_VELOCITY_DECIM 10U                  // PWM periods per velocity sample (= ENC_UPDATE_DECIM)
+#define CHIRP_VELOCITY_RATE_HZ (PWM_FREQ_HZ / CHIRP_VELOCITY_DECIM)
+#define CHIRP_VELOCITY_RING 64U                   // Velocity samples buffered between polls (32 ms)
+#define CHIRP_STEP_FRAC_BITS 16U                  // Extra fraction bits of the phase step
+
+// --- Lock-in Result ---
+typedef struct {
+    float frequency_hz; // Actual excitation frequency (phase step quantized)
+    float amplitude_V;  // Actual sine amplitude (compare value quantized)
+    float i_dc;         // DC current from the excitation offset (A)
+    float i_re;         // Current component in phase with the voltage (A)
+    float i_im;         // Current component in quadrature (A, negative when lagging)
+    float z_re;         // Resistive part of the impedance (Ohms)
+    float z_im;         // Reactive part of the impedance (Ohms)
+    uint32_t samples;   // Samples correlated
+} LockinResult;
+
+// --- Lock-in Status (resumable measurement) ---
+typedef enum {
+    LOCKIN_BUSY,   // Waiting for more samples
+    LOCKIN_DONE,   // Result is valid
+    LOCKIN_FAILED  // Not started, overrun or no current
+} LockinStatus;
+
+// --- Chirp Record ---
+// Everything the host needs to regenerate the applied voltage sample by sample:
+// step(0) = round(f_start / ADC_SAMPLE_RATE_HZ * 2^32) << CHIRP_STEP_FRAC_BITS,
+// step(n+1) = step(n) + (((step(n) >> CHIRP_STEP_FRAC_BITS) * growth) >> CHIRP_STEP_FRAC_BITS),
+// phase(n+1) = phase(n) + (step(n) >> CHIRP_STEP_FRAC_BITS), counts(n) = (amp * sine_table[phase(n)]) >> 15
+typedef struct {
+    uint32_t amp;             // Bridge counts of the sine amplitude
+    uint32_t growth;          // Step growth per sample, Q32
+    uint32_t samples;         // Samples played
+    float f_end_hz;           // Frequency reached (growth quantized)
+    uint32_t velocity_lost;   // Velocity samples overwritten before chirp_poll() read them
+} ChirpResult;
+
+// --- Impedance Spectrum ---
+typedef struct {
+    float frequency_hz; // Tone frequency
+    float z_re;         // Resistive part (Ohms)
+    float z_im;         // Reactive part (Ohms)
+} ImpedancePoint;
+
+typedef struct {
+    uint8_t tones;                               // Valid entries in point[]
+    ImpedancePoint point[MULTISINE_MAX_TONES];   // Z(f), ascending frequency
+    float crest_factor;                          // Peak / RMS of the excitation
+    float R0;                                    // Fitted R(f) = R0 + R_slope * f (Ohms)
+    float R_slope;                               // Ohms/Hz, > 0 with eddy-current losses
+    float L0;                                    // Fitted L(f) = L0 + L_slope * f (H)
+    float L_slope;                               // H/Hz, < 0 with eddy-current shielding
+    uint32_t samples;                            // Samples correlated
+} ImpedanceSpectrum;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Builds the Q15 sine tables used for excitation and demodulation.
+ * @note Called once; lockin_measure() and multisine_measure() call it on first use.
+ */
+void lockin_init(void);
+
+/**
+ * @brief Measures the impedance at one frequency by synchronous demodulation (blocking).
+ * @note The PWM update ISR plays V = A + A*sin(phase) through bridge_write() (signed,
+ *       dead-time compensated); the DC bias keeps the current one-signed, away from the
+ *       zero crossing where the compensation is least exact. Every current sample of the
+ *       ADC stream is correlated with sin/cos of the same phase in a single pass.
+ *       Runs LOCKIN_SETTLE_CYCLES + cycles periods of excitation.
+ * @param amplitude_V Sine amplitude in Volts (2*amplitude_V must not exceed V_SUPPLY).
+ * @param frequency_hz Excitation frequency in Hz (below ADC_SAMPLE_RATE_HZ / 4).
+ * @param cycles Number of whole excitation cycles to correlate over.
+ * @param result Filled on success.
+ * @return false on invalid arguments or sample stream overrun.
+ */
+bool lockin_measure(float amplitude_V, float frequency_hz, uint32_t cycles, LockinResult *result);
+
+/**
+ * @brief Starts a resumable single-tone measurement (same parameters as lockin_measure()).
+ * @return false if one is already running or the arguments are invalid.
+ */
+bool lockin_start(float amplitude_V, float frequency_hz, uint32_t cycles);
+
+/**
+ * @brief Correlates the samples available now without blocking.
+ * @note Call periodically (at least every ADC_DMA_HALF_SIZE samples) until it stops returning LOCKIN_BUSY.
+ */
+LockinStatus lockin_poll(LockinResult *result);
+
+/**
+ * @brief Stops a running measurement and the excitation.
+ */
+void lockin_abort(void);
+
+/**
+ * @brief Measures Z(f) at several frequencies from one multisine excitation window.
+ * @note Tones are log-spaced harmonics of ADC_SAMPLE_RATE_HZ / MULTISINE_PERIOD with
+ *       Schroeder phases to keep the crest factor low. The whole period is precomputed
+ *       into compare values; one correlator per tone demodulates every sample in a single
+ *       pass. R(f) and L(f) are then fitted by least squares across the tones.
+ *       Runs (LOCKIN_SETTLE_CYCLES + periods) * MULTISINE_PERIOD samples.
+ * @param amplitude_V Peak AC voltage in Volts, applied on a DC offset of the same size.
+ * @param f_min_hz Lowest tone (rounded up to the resolution).
+ * @param f_max_hz Highest tone (at most ADC_SAMPLE_RATE_HZ / 8).
+ * @param tones Number of tones, 2..MULTISINE_MAX_TONES (fewer if harmonics coincide).
+ * @param periods Multisine periods to correlate over.
+ * @param spectrum Filled on success.
+ * @return false on invalid arguments or sample stream overrun.
+ */
+bool multisine_measure(float amplitude_V, float f_min_hz, float f_max_hz, uint8_t tones,
+                       uint32_t periods, ImpedanceSpectrum *spectrum);
+
+/**
+ * @brief Starts an exponential sine sweep on the bridge for one capture of the full dynamics.
+ * @note Zero-mean bipolar V = A*sin(phase), the frequency growing by the same factor every
+ *       sample, so each decade gets equal time: the mechanical pole near the start, the
+ *       electrical one near the end. The update ISR also latches the velocity every
+ *       CHIRP_VELOCITY_DECIM periods. Shaft UNLOCKED; the current loop is released.
+ * @param amplitude_V Sine amplitude in Volts (at most V_SUPPLY).
+ * @param f_start_hz Start frequency in Hz.
+ * @param f_end_hz End frequency in Hz (above f_start_hz, below ADC_SAMPLE_RATE_HZ / 4).
+ * @param duration_s Sweep duration in seconds.
+ * @return false if an excitation is running or the arguments are invalid.
+ */
+bool chirp_start(float amplitude_V, float f_start_hz, float f_end_hz, float duration_s);
+
+/**
+ * @brief Consumes the current and velocity samples available now without blocking.
+ * @note Call periodically (at least every ADC_DMA_HALF_SIZE samples). The samples are only
+ *       read for the raw capture (motor_capture.h): current through adc_stream_read(),
+ *       velocity as capture_velocity_sample() at CHIRP_VELOCITY_RATE_HZ, index 0 at the start.
+ * @return LOCKIN_DONE once every sample of the sweep is read, LOCKIN_FAILED on stream overrun.
+ */
+LockinStatus chirp_poll(ChirpResult *result);
+
+/**
+ * @brief Stops a running sweep.
+ */
+void chirp_abort(void);
+
+/**
+ * @brief Writes the next excitation compare value.
+ * @note Call from the TIM1 update interrupt (HAL_TIM_PeriodElapsedCallback); does nothing when idle.
+ */
+void lockin_pwm_update(void);
+
+#endif /* INC_MOTOR_LOCKIN_H_ */
@@ -0,0 +1,40 @@
+#include "motor_log.h"
+
+#if defined(DEBUG_PRINT) && !defined(DEBUG_PRINT_TEXT) && !defined(HOST_SIM)
+
+#include "main.h"        // HAL_GetTick
+#include "SEGGER_RTT.h"
+
+// --- Log State ---
+static uint8_t rtt_buffer[LOG_RTT_BUFFER_SIZE];
+static volatile uint32_t dropped = 0; // Records lost since the last one that went out
+
+// --- Public Functions ---
+
+void log_start(void) {
+    // Skip mode: a record goes out whole or not at all, the caller never waits for the host
+    SEGGER_RTT_ConfigUpBuffer(LOG_RTT_CHANNEL, "DcmLog", rtt_buffer, sizeof(rtt_buffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+void log_write(const char *fmt, uint32_t n, const uint32_t *args) {
+    uint32_t rec[2U + LOG_MAX_ARGS];
+
+    if (dropped > 0U) {
+        rec[0] = (1U << 24) | LOG_ADDR_DROPPED;
+        rec[1] = HAL_GetTick();
+        rec[2] = dropped;
+        if (SEGGER_RTT_Write(LOG_RTT_CHANNEL, rec, 3U * sizeof(uint32_t)) == 0U) {
+            dropped++;
+            return;
+        }
+        dropped = 0U;
+    }
+
+    rec[0] = (n << 24) | ((uint32_t)fmt & LOG_ADDR_MASK);
+    rec[1] = HAL_GetTick();
+    for (uint32_t i = 0; i < n; i++) rec[2U + i] = args[i];
+    if (SEGGER_RTT_Write(LOG_RTT_CHANNEL, rec, (2U + n) * sizeof(uint32_t)) == 0U) dropped++;
+}
+
+#endif // DEBUG_PRINT && !DEBUG_PRINT_TEXT && !HOST_SIM
@@ -0,0 +1,100 @@
+#ifndef INC_MOTOR_LOG_H_
+#define INC_MOTOR_LOG_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "debug.h" // DEBUG_PRINT, text DEBUG_INIT() / DEBUG_PRINTF()
+
+// --- Deferred Log Configuration ---
+// With DEBUG_PRINT, DEBUG_PRINTF() no longer formats on the target: it writes the address of
+// its format string and the raw argument words to an RTT up channel (tens of cycles instead of
+// the thousands a %f costs), and host/log_decode rebuilds the text from the firmware ELF.
+// The format strings live in the non-loaded section .log_fmt, so they cost no flash. Add to the
+// linker script, after the loaded sections:
+//   .log_fmt 0 (INFO) : { KEEP(*(.log_fmt)) }
+// Record with e.g.
+//   JLinkRTTLogger -Device STM32F407VG -If SWD -Speed 4000 -RTTChannel 2 run_0001.log
+// Define DEBUG_PRINT_TEXT to get the formatted text of debug.h back.
+#define LOG_RTT_CHANNEL 2U
+#define LOG_RTT_BUFFER_SIZE 2048U
+#define LOG_MAX_ARGS 12U
+
+// --- Record Format ---
+// Little-endian u32 words: header, tick_ms, args[n].
+// header = n << 24 | format string address (.log_fmt starts at 0, so it fits 24 bits).
+// Floating-point arguments are sent as float bit patterns, everything else as 32-bit integers;
+// %s arguments are string addresses, resolved from the ELF when they point into flash.
+#define LOG_ADDR_MASK 0x00FFFFFFU
+#define LOG_ADDR_DROPPED LOG_ADDR_MASK // One arg: records lost since the last one that went out
+
+#if defined(DEBUG_PRINT) && !defined(DEBUG_PRINT_TEXT) && !defined(HOST_SIM)
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Configures the log RTT channel (non-blocking, whole records or nothing).
+ */
+void log_start(void);
+
+/**
+ * @brief Writes one record; safe from interrupts.
+ * @param fmt Format string in .log_fmt.
+ * @param n Number of argument words.
+ * @param args Argument words.
+ */
+void log_write(const char *fmt, uint32_t n, const uint32_t *args);
+
+// --- Argument Encoding ---
+
+static inline uint32_t log_word_float(double v) {
+    float f = (float)v;
+    uint32_t w;
+    memcpy(&w, &f, sizeof(w));
+    return w;
+}
+
+static inline uint32_t log_word_int(uint32_t v) {
+    return v;
+}
+
+static inline uint32_t log_word_ptr(const void *p) {
+    return (uint32_t)p;
+}
+
+#define LOG_WORD(x) _Generic((x), \
+    float: log_word_float, double: log_word_float, \
+    char *: log_word_ptr, const char *: log_word_ptr, void *: log_word_ptr, const void *: log_word_ptr, \
+    default: log_word_int)(x)
+
+#define LOG_NARGS(...) LOG_NARGS_(_, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, n, ...) n
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+#define LOG_WORDS_0()
+#define LOG_WORDS_1(a) LOG_WORD(a),
+#define LOG_WORDS_2(a, ...) LOG_WORD(a), LOG_WORDS_1(__VA_ARGS__)
+#define LOG_WORDS_3(a, ...) LOG_WORD(a), LOG_WORDS_2(__VA_ARGS__)
+#define LOG_WORDS_4(a, ...) LOG_WORD(a), LOG_WORDS_3(__VA_ARGS__)
+#define LOG_WORDS_5(a, ...) LOG_WORD(a), LOG_WORDS_4(__VA_ARGS__)
+#define LOG_WORDS_6(a, ...) LOG_WORD(a), LOG_WORDS_5(__VA_ARGS__)
+#define LOG_WORDS_7(a, ...) LOG_WORD(a), LOG_WORDS_6(__VA_ARGS__)
+#define LOG_WORDS_8(a, ...) LOG_WORD(a), LOG_WORDS_7(__VA_ARGS__)
+#define LOG_WORDS_9(a, ...) LOG_WORD(a), LOG_WORDS_8(__VA_ARGS__)
+#define LOG_WORDS_10(a, ...) LOG_WORD(a), LOG_WORDS_9(__VA_ARGS__)
+#define LOG_WORDS_11(a, ...) LOG_WORD(a), LOG_WORDS_10(__VA_ARGS__)
+#define LOG_WORDS_12(a, ...) LOG_WORD(a), LOG_WORDS_11(__VA_ARGS__)
+
+// Keeps every existing call site: the literal becomes a .log_fmt entry, the arguments raw words
+#undef DEBUG_INIT
+#undef DEBUG_PRINTF
+#define DEBUG_INIT() log_start()
+#define DEBUG_PRINTF(fmt, ...) do { \
+        static const char log_fmt_[] __attribute__((section(".log_fmt"), used)) = fmt; \
+        const uint32_t log_args_[LOG_NARGS(__VA_ARGS__) + 1U] = { \
+            LOG_CAT(LOG_WORDS_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__) 0U }; \
+        log_write(log_fmt_, LOG_NARGS(__VA_ARGS__), log_args_); \
+    } while (0)
+
+#endif // DEBUG_PRINT && !DEBUG_PRINT_TEXT && !HOST_SIM
+
+#endif /* INC_MOTOR_LOG_H_ */
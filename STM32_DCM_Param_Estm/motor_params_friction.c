@@ -0,0 +1,334 @@
+#include "motor_params_friction.h"
+#include <math.h>
+
+// --- Friction Map State ---
+FrictionModel motor_friction = { 0 };
+static float lut[2][FRICTION_LUT_SIZE]; // Torque magnitude at |w| = i * w_max / (FRICTION_LUT_SIZE - 1)
+static float lut_inv_step = 0.0f;
+static bool map_valid = false;
+
+// --- Internal Helper Functions ---
+
+// Solves the 3x3 system a * x = b (Gaussian elimination with partial pivoting)
+static bool solve3(double a[3][3], double b[3], double x[3]) {
+    for (uint8_t c = 0; c < 3; c++) {
+        uint8_t p = c;
+        for (uint8_t r = c + 1; r < 3; r++) {
+            if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+        }
+        if (fabs(a[p][c]) < 1e-12 * (fabs(a[0][0]) + 1e-30)) return false; // Collinear columns
+        if (p != c) {
+            for (uint8_t j = 0; j < 3; j++) {
+                double tmp = a[c][j];
+                a[c][j] = a[p][j];
+                a[p][j] = tmp;
+            }
+            double tmp = b[c];
+            b[c] = b[p];
+            b[p] = tmp;
+        }
+        for (uint8_t r = c + 1; r < 3; r++) {
+            double f = a[r][c] / a[c][c];
+            for (uint8_t j = c; j < 3; j++) a[r][j] -= f * a[c][j];
+            b[r] -= f * b[c];
+        }
+    }
+    for (int8_t i = 2; i >= 0; i--) {
+        double v = b[i];
+        for (uint8_t j = (uint8_t)(i + 1); j < 3; j++) v -= a[i][j] * x[j];
+        x[i] = v / a[i][i];
+    }
+    return true;
+}
+
+// Search stages of the resumable fit, in order
+enum {
+    FIT_GRID,      // Coarse log grid of ws
+    FIT_GOLDEN_C,  // Golden section around the best grid point, first probe
+    FIT_GOLDEN_D,  // Same, second probe
+    FIT_REFINE,    // Midpoint of the final bracket
+    FIT_FINAL,     // Best ws, keeping theta per direction
+    FIT_FALLBACK,  // Coulomb + viscous only (ws = 0) for directions without a Stribeck dip
+    FIT_FAILED
+};
+
+#define GOLDEN_RATIO 0.6180339887
+#define GOLDEN_ITERATIONS 24U
+
+// Clears the normal equations and starts accumulating them for ws (<= 0: no Stribeck column)
+static void eval_start(FrictionFit *fit, uint8_t stage, double ws) {
+    fit->stage = stage;
+    fit->ws = ws;
+    fit->point = 0;
+    for (uint8_t d = 0; d < 2; d++) {
+        for (uint8_t i = 0; i < 3; i++) {
+            for (uint8_t j = 0; j < 3; j++) fit->ata[d][i][j] = 0.0;
+            fit->atb[d][i] = 0.0;
+        }
+        fit->yty[d] = 0.0;
+    }
+}
+
+// One point into the normal equations of its direction: theta = [Tc, Ts - Tc, B]
+static void eval_point(FrictionFit *fit, uint8_t k) {
+    uint8_t d = (fit->data->w[k] < 0.0f) ? 1U : 0U;
+    if (!fit->use[d]) return;
+    double x = fabs(fit->data->w[k]);
+    double y = (d == 1) ? -fit->data->torque[k] : fit->data->torque[k];
+    double phi[3] = { 1.0, 0.0, x };
+    if (fit->ws > 0.0) phi[1] = exp(-(x / fit->ws) * (x / fit->ws));
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) fit->ata[d][i][j] += phi[i] * phi[j];
+        fit->atb[d][i] += phi[i] * y;
+    }
+    fit->yty[d] += y * y;
+}
+
+// Least squares of one accumulated direction. Returns the SSE, or -1 if singular.
+static double eval_solve(FrictionFit *fit, uint8_t d, double theta[3]) {
+    if (fit->ws <= 0.0) fit->ata[d][1][1] = 1.0; // Pins theta[1] to 0
+
+    double b[3] = { fit->atb[d][0], fit->atb[d][1], fit->atb[d][2] };
+    if (!solve3(fit->ata[d], b, theta)) return -1.0;
+    double sse = fit->yty[d] - theta[0] * fit->atb[d][0] - theta[1] * fit->atb[d][1] - theta[2] * fit->atb[d][2];
+    return (sse > 0.0) ? sse : 0.0;
+}
+
+static void golden_start(FrictionFit *fit) {
+    eval_start(fit, FIT_GOLDEN_C, exp(fit->b - GOLDEN_RATIO * (fit->b - fit->a)));
+}
+
+static void final_start(FrictionFit *fit) {
+    if (fit->best_sse >= 0.0) {
+        eval_start(fit, FIT_FINAL, fit->best_ws);
+        return;
+    }
+    fit->fallback[0] = fit->use[0];
+    fit->fallback[1] = fit->use[1];
+    eval_start(fit, FIT_FALLBACK, 0.0);
+}
+
+// Checks the per-direction fits and fills the model
+static FrictionFitStatus finish(FrictionFit *fit, FrictionModel *model) {
+    double sse_total = 0.0;
+    uint8_t used = 0;
+    for (uint8_t d = 0; d < 2; d++) {
+        if (!fit->use[d]) continue;
+        if (fit->sse[d] < 0.0 || fit->theta[d][0] < 0.0 || fit->theta[d][2] < 0.0) {
+            fit->stage = FIT_FAILED;
+            return FRICTION_FIT_FAILED;
+        }
+        sse_total += fit->sse[d];
+        used += fit->count[d];
+    }
+    for (uint8_t d = 0; d < 2; d++) {
+        if (fit->use[d]) continue;
+        for (uint8_t j = 0; j < 3; j++) fit->theta[d][j] = fit->theta[1 - d][j]; // Mirror
+    }
+
+    for (uint8_t d = 0; d < 2; d++) {
+        model->Tc[d] = (float)fit->theta[d][0];
+        model->Ts[d] = (float)(fit->theta[d][0] + fit->theta[d][1]);
+        model->B[d] = (float)fit->theta[d][2];
+    }
+    model->ws = (fit->best_sse >= 0.0) ? (float)fit->best_ws : 0.0f;
+    model->w_max = fit->w_hi;
+    model->rms = (float)sqrt(sse_total / used);
+    return FRICTION_FIT_DONE;
+}
+
+// --- Public Functions ---
+
+float friction_sweep_velocity(uint8_t i, uint8_t n, float w_min, float w_max) {
+    if (n < 2) return w_max;
+    return w_max * powf(w_min / w_max, (float)i / (float)(n - 1));
+}
+
+void friction_data_reset(FrictionData *data) {
+    data->n = 0;
+}
+
+bool friction_data_add(FrictionData *data, float w, float torque) {
+    if (data->n >= 2U * FRICTION_SWEEP_MAX || w == 0.0f) return false;
+    data->w[data->n] = w;
+    data->torque[data->n] = torque;
+    data->n++;
+    return true;
+}
+
+bool friction_fit(const FrictionData *data, FrictionModel *model) {
+    FrictionFit fit;
+    FrictionFitStatus status;
+    friction_fit_start(&fit, data);
+    do {
+        status = friction_fit_step(&fit, UINT32_MAX, model);
+    } while (status == FRICTION_FIT_BUSY);
+    return status == FRICTION_FIT_DONE;
+}
+
+void friction_fit_start(FrictionFit *fit, const FrictionData *data) {
+    float w_lo = INFINITY, w_hi = 0.0f;
+    fit->data = data;
+    fit->count[0] = 0;
+    fit->count[1] = 0;
+    for (uint8_t k = 0; k < data->n; k++) {
+        float x = fabsf(data->w[k]);
+        fit->count[data->w[k] < 0.0f]++;
+        if (x < w_lo) w_lo = x;
+        if (x > w_hi) w_hi = x;
+    }
+    fit->use[0] = fit->count[0] >= FRICTION_MIN_POINTS;
+    fit->use[1] = fit->count[1] >= FRICTION_MIN_POINTS;
+    fit->w_hi = w_hi;
+    fit->fallback[0] = false;
+    fit->fallback[1] = false;
+    fit->best_ws = 0.0;
+    fit->best_sse = -1.0;
+    fit->best_k = 0;
+    if (!fit->use[0] && !fit->use[1]) {
+        fit->stage = FIT_FAILED;
+        return;
+    }
+
+    // Coarse log grid for ws (one shared Stribeck velocity), then golden section around the best
+    fit->lo = 0.25 * w_lo;
+    fit->ratio = pow(w_hi / fit->lo, 1.0 / (FRICTION_WS_GRID - 1U));
+    fit->iter = 0;
+    eval_start(fit, FIT_GRID, fit->lo);
+}
+
+FrictionFitStatus friction_fit_step(FrictionFit *fit, uint32_t max_points, FrictionModel *model) {
+    if (fit->stage == FIT_FAILED) return FRICTION_FIT_FAILED;
+
+    // Accumulate the current candidate first; solving it is a step of its own
+    if (fit->point < fit->data->n) {
+        for (uint32_t i = 0; i < max_points && fit->point < fit->data->n; i++) eval_point(fit, fit->point++);
+        return FRICTION_FIT_BUSY;
+    }
+
+    // Summed SSE of the fitted directions, -1 if any of them is singular
+    double theta[2][3] = { { 0.0 } };
+    double sse[2] = { 0.0, 0.0 };
+    double total = 0.0;
+    for (uint8_t d = 0; d < 2; d++) {
+        if (!fit->use[d]) continue;
+        sse[d] = eval_solve(fit, d, theta[d]);
+        if (sse[d] < 0.0 || total < 0.0) total = -1.0;
+        else total += sse[d];
+    }
+
+    switch (fit->stage) {
+    case FIT_GRID:
+        if (total >= 0.0 && (fit->best_sse < 0.0 || total < fit->best_sse)) {
+            fit->best_sse = total;
+            fit->best_ws = fit->ws;
+            fit->best_k = fit->iter;
+        }
+        if (++fit->iter < FRICTION_WS_GRID) {
+            eval_start(fit, FIT_GRID, fit->lo * pow(fit->ratio, fit->iter));
+        } else if (fit->best_sse >= 0.0) {
+            uint8_t k = fit->best_k;
+            fit->a = log(fit->lo * pow(fit->ratio, k > 0 ? k - 1 : 0));
+            fit->b = log(fit->lo * pow(fit->ratio, k + 1U < FRICTION_WS_GRID ? k + 1 : k));
+            fit->iter = 0;
+            golden_start(fit);
+        } else {
+            final_start(fit);
+        }
+        return FRICTION_FIT_BUSY;
+
+    case FIT_GOLDEN_C:
+        fit->fc = total;
+        eval_start(fit, FIT_GOLDEN_D, exp(fit->a + GOLDEN_RATIO * (fit->b - fit->a)));
+        return FRICTION_FIT_BUSY;
+
+    case FIT_GOLDEN_D: {
+        double c = fit->b - GOLDEN_RATIO * (fit->b - fit->a), d = fit->a + GOLDEN_RATIO * (fit->b - fit->a);
+        if (fit->fc >= 0.0 && total >= 0.0) {
+            if (fit->fc < total) fit->b = d; else fit->a = c;
+            if (++fit->iter < GOLDEN_ITERATIONS) {
+                golden_start(fit);
+                return FRICTION_FIT_BUSY;
+            }
+        }
+        eval_start(fit, FIT_REFINE, exp(0.5 * (fit->a + fit->b)));
+        return FRICTION_FIT_BUSY;
+    }
+
+    case FIT_REFINE:
+        if (total >= 0.0 && total < fit->best_sse) {
+            fit->best_sse = total;
+            fit->best_ws = fit->ws;
+        }
+        final_start(fit);
+        return FRICTION_FIT_BUSY;
+
+    case FIT_FINAL: {
+        // Per direction: no (or inverted) Stribeck dip falls back to Coulomb + viscous
+        bool any = false;
+        for (uint8_t d = 0; d < 2; d++) {
+            if (!fit->use[d]) continue;
+            fit->sse[d] = sse[d];
+            for (uint8_t j = 0; j < 3; j++) fit->theta[d][j] = theta[d][j];
+            fit->fallback[d] = sse[d] < 0.0 || theta[d][1] < 0.0;
+            any = any || fit->fallback[d];
+        }
+        if (any) {
+            eval_start(fit, FIT_FALLBACK, 0.0);
+            return FRICTION_FIT_BUSY;
+        }
+        return finish(fit, model);
+    }
+
+    case FIT_FALLBACK:
+        for (uint8_t d = 0; d < 2; d++) {
+            if (!fit->fallback[d]) continue;
+            fit->sse[d] = sse[d];
+            for (uint8_t j = 0; j < 3; j++) fit->theta[d][j] = theta[d][j];
+        }
+        return finish(fit, model);
+
+    default:
+        fit->stage = FIT_FAILED;
+        return FRICTION_FIT_FAILED;
+    }
+}
+
+void friction_map_load(const FrictionModel *model) {
+    motor_friction = *model;
+    map_valid = false; // friction_torque() returns 0 while the table is rebuilt
+    if (model->w_max <= 0.0f) return;
+
+    float step = model->w_max / (float)(FRICTION_LUT_SIZE - 1U);
+    for (uint8_t d = 0; d < 2; d++) {
+        for (uint32_t i = 0; i < FRICTION_LUT_SIZE; i++) {
+            float x = step * (float)i;
+            float stribeck = (model->ws > 0.0f) ? expf(-(x / model->ws) * (x / model->ws)) : 0.0f;
+            lut[d][i] = model->Tc[d] + (model->Ts[d] - model->Tc[d]) * stribeck + model->B[d] * x;
+        }
+    }
+    lut_inv_step = 1.0f / step;
+    map_valid = true;
+}
+
+bool friction_map_valid(void) {
+    return map_valid;
+}
+
+float friction_torque(float w) {
+    if (!map_valid) return 0.0f;
+    uint8_t d = (w < 0.0f) ? 1U : 0U;
+    float x = fabsf(w);
+    float t;
+
+    float pos = x * lut_inv_step;
+    if (pos >= (float)(FRICTION_LUT_SIZE - 1U)) {
+        t = lut[d][FRICTION_LUT_SIZE - 1U] + motor_friction.B[d] * (x - motor_friction.w_max);
+    } else {
+        uint32_t i = (uint32_t)pos;
+        float f = pos - (float)i;
+        t = lut[d][i] + f * (lut[d][i + 1U] - lut[d][i]);
+    }
+    if (x < FRICTION_ZERO_BAND) t *= x / FRICTION_ZERO_BAND;
+    return d ? -t : t;
+}
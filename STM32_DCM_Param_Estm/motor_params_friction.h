@@ -0,0 +1,125 @@
+#ifndef INC_MOTOR_PARAMS_FRICTION_H_
+#define INC_MOTOR_PARAMS_FRICTION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Friction Sweep Configuration ---
+#define FRICTION_SWEEP_MAX 16U       // Speeds per direction
+#define FRICTION_MIN_POINTS 4U       // Steady points a direction needs for its own fit
+#define FRICTION_WS_GRID 32U         // Stribeck velocity candidates (log spaced)
+#define FRICTION_LUT_SIZE 64U        // Table entries per direction
+#define FRICTION_ZERO_BAND 0.2f      // |w| below which compensation ramps to zero (rad/s)
+
+// --- Friction Model ---
+// Steady-state friction torque for w > 0 (the negative direction has its own Tc, Ts, B):
+//   T(w) = Tc + (Ts - Tc) * exp(-(w / ws)^2) + B * w
+// Linear in [Tc, Ts - Tc, B] for a fixed ws, so ws is searched and the rest solved by least squares.
+typedef struct {
+    float Tc[2];   // Coulomb friction [positive, negative direction] (Nm, magnitude)
+    float Ts[2];   // Static (breakaway) friction (Nm, magnitude)
+    float B[2];    // Viscous friction (Nm/(rad/s))
+    float ws;      // Stribeck velocity (rad/s)
+    float w_max;   // Fastest swept speed, end of the lookup table (rad/s)
+    float rms;     // Residual torque RMS (Nm)
+} FrictionModel;
+
+// Steady-state points collected by the sweep
+typedef struct {
+    float w[2U * FRICTION_SWEEP_MAX];      // Velocity (rad/s)
+    float torque[2U * FRICTION_SWEEP_MAX]; // Motor torque holding that velocity (Nm, signed)
+    uint8_t n;
+} FrictionData;
+
+// --- Resumable Fit ---
+// friction_fit() split into steps of a few points, for callers with a time budget per tick
+// (the estimation sequence). Every step either accumulates points for one ws candidate or
+// solves them and moves the search on; the sequence of candidates is the same as in one go.
+typedef enum {
+    FRICTION_FIT_BUSY,    // Call friction_fit_step() again
+    FRICTION_FIT_DONE,    // Model is valid
+    FRICTION_FIT_FAILED   // Too few points or not physical
+} FrictionFitStatus;
+
+typedef struct {
+    const FrictionData *data;
+    bool use[2];                  // Directions with FRICTION_MIN_POINTS
+    uint8_t count[2];
+    float w_hi;
+    uint8_t stage;                // Search stage (motor_params_friction.c)
+    uint8_t iter;                 // Grid index or golden-section iteration
+    double lo, ratio;             // Log grid of ws candidates
+    double a, b, fc;              // Golden-section bracket (ln ws), f at its first point
+    double best_ws, best_sse;
+    uint8_t best_k;
+    bool fallback[2];             // Direction refitted without the Stribeck term
+    double theta[2][3];           // Final [Tc, Ts - Tc, B] per direction
+    double sse[2];
+    // Normal equations of the candidate under evaluation, per direction
+    double ws;
+    uint8_t point;                // Next data point to accumulate
+    double ata[2][3][3];
+    double atb[2][3];
+    double yty[2];
+} FrictionFit;
+
+extern FrictionModel motor_friction; // Last fit, backs friction_torque()
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Sweep speed number i of n for one direction, log spaced from w_max down to w_min.
+ * @note High to low, so every point is approached from above like the Stribeck branch.
+ */
+float friction_sweep_velocity(uint8_t i, uint8_t n, float w_min, float w_max);
+
+/**
+ * @brief Clears the collected points.
+ */
+void friction_data_reset(FrictionData *data);
+
+/**
+ * @brief Adds one steady-state point.
+ * @return false if the buffer is full or the point is at standstill.
+ */
+bool friction_data_add(FrictionData *data, float w, float torque);
+
+/**
+ * @brief Least-squares fit of the friction model to the collected points.
+ * @note A direction with fewer than FRICTION_MIN_POINTS mirrors the other one.
+ * @return false if neither direction has enough points or the result is not physical.
+ */
+bool friction_fit(const FrictionData *data, FrictionModel *model);
+
+/**
+ * @brief Starts friction_fit() in steps; data must stay unchanged until it is done.
+ */
+void friction_fit_start(FrictionFit *fit, const FrictionData *data);
+
+/**
+ * @brief Accumulates up to max_points data points, or solves the current candidate.
+ * @note Bounded cost per call: max_points rows (one double exp each) or two 3x3 solves
+ *       plus the next candidate's ws. The result equals friction_fit() on the same data.
+ * @param model Filled when FRICTION_FIT_DONE is returned.
+ */
+FrictionFitStatus friction_fit_step(FrictionFit *fit, uint32_t max_points, FrictionModel *model);
+
+/**
+ * @brief Makes model the active one and tabulates it for friction_torque().
+ */
+void friction_map_load(const FrictionModel *model);
+
+/**
+ * @brief True once a model has been loaded.
+ */
+bool friction_map_valid(void);
+
+/**
+ * @brief Friction torque at velocity w (Nm, signed like w), for feedforward compensation.
+ * @note O(1): one table interpolation, viscous extrapolation beyond w_max, and a linear
+ *       ramp through FRICTION_ZERO_BAND so the compensation does not chatter at standstill.
+ *       Returns 0 while no map is loaded.
+ */
+float friction_torque(float w);
+
+#endif /* INC_MOTOR_PARAMS_FRICTION_H_ */
@@ -1,57 +1,94 @@
 #include "motor_params_jb.h"
 #include <math.h>
-#include "debug.h" // Include the debug print header
+#include "motor_encoder.h" // M/T and PLL velocity estimation
+#include "motor_capture.h" // Raw sample capture of estimation phases
+#include "motor_params_friction.h" // Friction map (feedforward)
+#include "motor_current_loop.h" // PI current control
+#include "motor_bridge.h" // Signed H-bridge output
+#include "motor_log.h" // DEBUG_PRINTF (deferred binary log over RTT)
 
 // --- Estimated Parameters (Definition) ---
 float motor_Ke = 0.0f;
 float motor_Kt = 0.0f;
 float motor_J = 0.0f;
 float motor_B = 0.0f;
+float motor_Tc = 0.0f;
 
 // --- Placeholder Function Implementations (Replace with actual code) ---
 
-// Reads velocity from an encoder or sensor (radians/second)
-float read_velo() {
-    // *** Replace with your actual encoder reading and conversion logic ***
-    // Example: return (float)read_encoder_ticks() * GEAR_RATIO * (2.0f * M_PI / ENCODER_CPR) / TIME_DELTA_S;
-    DEBUG_PRINTF("Warning: Using placeholder read_velo()\n");
-    return 0.0f;
+// Reads velocity from the encoder (radians/second)
+float read_velo(void) {
+    // M/T or PLL estimate, refreshed at ENC_UPDATE_RATE_HZ from the TIM1 update ISR
+    return encoder_velocity();
 }
 
 // Reads the actual voltage applied to the motor terminals
-float read_Vs() {
+float read_Vs(void) {
     // *** Replace with your actual voltage measurement or estimation logic ***
     // Example: return V_SUPPLY * (__HAL_TIM_GET_COMPARE(&htim1, TIM_CHANNEL_1) / (float)(htim1.Instance->ARR));
+    if (current_loop_enabled()) return current_loop_voltage(); // Commanded by the current loop
     DEBUG_PRINTF("Warning: Using placeholder read_Vs()\n");
      return 0.0f;
 }
 
-// Ideal current controller (Placeholder - replace with real controller)
+// Current controller: PI loop in the injected ADC interrupt at PWM rate (motor_current_loop.c)
 void DCM_Ctl_Curr(float target_current) {
-    // *** Replace with your actual current control loop ***
-    DEBUG_PRINTF("Placeholder: Setting current to: %.3f A\n", target_current);
-    // Example conceptual action: Adjust PWM until read_motor_current() matches target_current
-    // For now, just set voltage proportional to current for basic simulation
-    // This is NOT a real current controller! Needs motor_R from rl module.
-    // float target_voltage = target_current * motor_R; // Highly simplified! Ignores L and back-EMF
-    // set_motor_voltage(target_voltage); // Need set_motor_voltage or direct PWM control here
-     __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0); // Default to off
+    // Gains follow the model in use when the loop is (re)engaged
+    if (!current_loop_enabled() && !current_loop_configure(motor_R, motor_L, motor_Ke)) {
+        DEBUG_PRINTF("Current control needs R and L estimated first.\n");
+        bridge_write(0); // Default to off
+        return;
+    }
+    current_loop_set_reference(target_current);
 }
 
 // Ideal velocity controller (Placeholder - replace with real controller)
 void DC_Ctl_Velo(float target_velocity_rad_s) {
     // *** Replace with your actual velocity control loop ***
     DEBUG_PRINTF("Placeholder: Setting velocity to: %.3f rad/s\n", target_velocity_rad_s);
-    // Example conceptual action: Adjust PWM until read_velo() matches target_velocity_rad_s
-    // For now, just set voltage proportional to velocity for basic simulation
-    // This is NOT a real velocity controller! Needs motor_Ke, motor_R.
-    // float target_voltage = target_velocity_rad_s * motor_Ke + motor_R * 0.1f; // Highly simplified! Assumes Ke known, low current
-    // set_motor_voltage(target_voltage); // Need set_motor_voltage or direct PWM control here
-    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0); // Default to off
+    // Open-loop model voltage for now: back-EMF plus the R drop of the friction current.
+    // The bridge is bipolar, so a negative target reverses the motor.
+    // This is NOT a real velocity controller! Needs motor_Ke, motor_R (and motor_Kt for friction).
+    float target_voltage = 0.0f;
+    if (motor_Ke > 0.0f) {
+        target_voltage = target_velocity_rad_s * motor_Ke;
+        if (motor_Kt > 0.0001f) target_voltage += motor_R * friction_torque(target_velocity_rad_s) / motor_Kt;
+    }
+    set_Vs(target_voltage); // Also releases the current loop; 0 V when Ke is not known yet
 }
 
 // --- Public Functions ---
 
+bool estm_Ke_from_steady(float steady_voltage, float steady_current, float steady_velocity) {
+    if (fabsf(steady_velocity) <= 0.01f) { // Avoid division by zero
+        motor_Ke = 0.0f;
+        motor_Kt = 0.0f;
+        DEBUG_PRINTF("Ke/Kt estimation failed (velocity too low or measurement error).\n");
+        return false;
+    }
+    float back_emf = steady_voltage - steady_current * motor_R;
+    motor_Ke = fabsf(back_emf / steady_velocity); // Ke is typically positive
+    motor_Kt = motor_Ke; // Assume Kt = Ke (SI units)
+    DEBUG_PRINTF("Estimated Ke: %.4f V/(rad/s), Assumed Kt: %.4f Nm/A\n", motor_Ke, motor_Kt);
+    return true;
+}
+
+bool estm_J_from_fit(const MechFit *fit, MechFitResult *res) {
+    if (!mech_fit_solve(fit, res)) {
+        motor_J = 0.0f;
+        DEBUG_PRINTF("J estimation failed (too little motion or measurement error).\n");
+        return false;
+    }
+    motor_J = res->J;
+    if (!friction_map_valid()) { // Steady-state sweep is the better friction estimate
+        motor_B = (res->B > 0.0f) ? res->B : 0.0f;
+        motor_Tc = (res->Tc > 0.0f) ? res->Tc : 0.0f;
+    }
+    DEBUG_PRINTF("Estimated J: %.6f kg*m^2, B: %.6f Nm/(rad/s), Tc: %.5f Nm (rms %.3f rad/s)\n",
+           motor_J, motor_B, motor_Tc, res->rms);
+    return true;
+}
+
 void estm_Ke_Kt(float test_velocity_rad_s) {
     if (motor_R < 0.001f) {
          DEBUG_PRINTF("Ke/Kt estimation skipped: Valid R required first.\n");
@@ -59,6 +96,8 @@ void estm_Ke_Kt(float test_velocity_rad_s) {
     }
 
     DEBUG_PRINTF("Estimating Ke/Kt (Shaft UNLOCKED!). Commanding %.2f rad/s...\n", test_velocity_rad_s);
+    float params[4] = { test_velocity_rad_s, motor_R };
+    capture_phase_begin(CAP_PHASE_KE, params);
     DC_Ctl_Velo(test_velocity_rad_s); // Command velocity
     HAL_Delay(2000); // Wait for steady state (adjust delay as needed)
 
@@ -68,23 +107,21 @@ void estm_Ke_Kt(float test_velocity_rad_s) {
 
     DEBUG_PRINTF("Steady state: Vel=%.3f rad/s, Curr=%.3f A, Volt=%.2f V\n",
            steady_velocity, steady_current, steady_voltage);
+    capture_velocity(0, 1, &steady_velocity, 1);
 
     // Optional: Add checks if steady_velocity is close enough to test_velocity_rad_s
 
-    if (fabsf(steady_velocity) > 0.01f) { // Avoid division by zero
-        float back_emf = steady_voltage - steady_current * motor_R;
-        motor_Ke = fabsf(back_emf / steady_velocity); // Ke is typically positive
-        motor_Kt = motor_Ke; // Assume Kt = Ke (SI units)
-        DEBUG_PRINTF("Estimated Ke: %.4f V/(rad/s), Assumed Kt: %.4f Nm/A\n", motor_Ke, motor_Kt);
-    } else {
-        motor_Ke = 0.0f;
-        motor_Kt = 0.0f;
-        DEBUG_PRINTF("Ke/Kt estimation failed (velocity too low or measurement error).\n");
-    }
+    bool ok = estm_Ke_from_steady(steady_voltage, steady_current, steady_velocity);
+    float results[4] = { motor_Ke, steady_voltage, steady_current, steady_velocity };
+    capture_phase_end(ok, results);
     DC_Ctl_Velo(0.0f); // Stop motor
     HAL_Delay(500);
 }
 
+float estm_steady_torque(float steady_current) {
+    return motor_Kt * fabsf(steady_current); // Torque_motor = Kt * I
+}
+
 void estm_Bm(float test_velocity_rad_s) {
     if (motor_Kt < 0.0001f) {
         DEBUG_PRINTF("B estimation skipped: Valid Kt required first.\n");
@@ -92,6 +129,8 @@ void estm_Bm(float test_velocity_rad_s) {
     }
 
     DEBUG_PRINTF("Estimating B (Shaft UNLOCKED!). Commanding %.2f rad/s...\n", test_velocity_rad_s);
+    float params[4] = { test_velocity_rad_s, motor_Kt };
+    capture_phase_begin(CAP_PHASE_B, params);
     DC_Ctl_Velo(test_velocity_rad_s); // Command velocity
     HAL_Delay(2000); // Wait for steady state
 
@@ -99,84 +138,82 @@ void estm_Bm(float test_velocity_rad_s) {
     float steady_current = read_motor_current(); // Need current reading
 
     DEBUG_PRINTF("Steady state for B: Vel=%.3f rad/s, Curr=%.3f A\n", steady_velocity, steady_current);
+    capture_velocity(0, 1, &steady_velocity, 1);
 
     // Optional: Add checks if steady_velocity is close enough to test_velocity_rad_s
 
-    if (fabsf(steady_velocity) > 0.01f) {
+    bool ok = fabsf(steady_velocity) > 0.01f;
+    if (ok) {
         // At steady state, Torque_motor = Torque_friction
-        // Torque_motor = Kt * I
         // Torque_friction = B * omega (viscous friction)
-        float friction_torque = motor_Kt * steady_current;
-        motor_B = fabsf(friction_torque / steady_velocity); // B is typically positive
+        motor_B = fabsf(estm_steady_torque(steady_current) / steady_velocity); // B is typically positive
         DEBUG_PRINTF("Estimated B: %.6f Nm/(rad/s)\n", motor_B);
     } else {
         motor_B = 0.0f;
         DEBUG_PRINTF("B estimation failed (velocity too low or measurement error).\n");
     }
+    float results[4] = { motor_B, steady_current, steady_velocity };
+    capture_phase_end(ok, results);
     DC_Ctl_Velo(0.0f); // Stop motor
     HAL_Delay(500);
 }
 
+// Waits for the armed velocity capture to finish
+static bool wait_capture(uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    while (!mech_capture_done()) {
+        if (HAL_GetTick() - start > timeout_ms) {
+            mech_capture_stop();
+            return false;
+        }
+    }
+    return true;
+}
+
 void estm_Jm(float test_current_step) {
-     if (motor_Kt < 0.0001f || motor_B < 0.0f) { // B can be zero, but check Kt
-        DEBUG_PRINTF("J estimation skipped: Valid Kt and B required first.\n");
+    if (motor_Kt < 0.0001f) {
+        DEBUG_PRINTF("J estimation skipped: Valid Kt required first.\n");
         return;
-     }
+    }
 
-    DEBUG_PRINTF("Estimating J (Shaft UNLOCKED!). Applying %.2f A current step...\n", test_current_step);
+    DEBUG_PRINTF("Estimating J/B/Tc (Shaft UNLOCKED!). Applying %.2f A current step...\n", test_current_step);
     // Ensure motor is stopped
     DC_Ctl_Velo(0.0f);
     HAL_Delay(1000);
 
-    float initial_velocity = read_velo();
-    uint32_t t1 = HAL_GetTick();
-
+    // Segment 1: torque step, fixed length
+    mech_capture_start(0, MECH_STEP_SAMPLES, 0.0f);
     DCM_Ctl_Curr(test_current_step); // Apply current step -> torque step
-
-    // Need to measure velocity change shortly after step
-    // This requires fast sampling. Delay is illustrative and CRITICAL.
-    HAL_Delay(20); // *** ADJUST THIS DELAY based on expected acceleration! ***
-
-    float final_velocity = read_velo();
-    uint32_t t2 = HAL_GetTick();
-
-    DCM_Ctl_Curr(0.0f); // Stop applying current
+    bool ok = wait_capture(MECH_STEP_MS + 100U);
+    uint32_t n_step = mech_capture_count();
+
+    // Segment 2: free coast-down until stopped or the buffer is full
+    DCM_Ctl_Curr(0.0f); // Zero torque, shaft coasts
+    mech_capture_start(n_step, MECH_CAPTURE_LEN - n_step, MECH_STOP_VELOCITY);
+    ok = ok && wait_capture(MECH_CAPTURE_LEN * 1000U / MECH_CAPTURE_RATE_HZ + 100U);
+    uint32_t n_coast = mech_capture_count();
     DC_Ctl_Velo(0.0f); // Command zero velocity for safety
 
-    float delta_t_ms = (float)(t2 - t1);
-    if (delta_t_ms < 1.0f) delta_t_ms = 1.0f; // Avoid division by zero if ticks are the same
-    float delta_t_s = delta_t_ms / 1000.0f;
-
-    // Calculate acceleration (alpha = delta_omega / delta_t)
-    float acceleration = (final_velocity - initial_velocity) / delta_t_s;
-
-    // Calculate average velocity during the short interval to estimate friction torque
-    float avg_velocity = (final_velocity + initial_velocity) / 2.0f;
-
-    // Calculate applied torque and friction torque
-    float applied_torque = motor_Kt * test_current_step;
-    float friction_torque = motor_B * avg_velocity; // Use estimated B
-
-    // Dynamic equation: T_applied - T_friction = J * alpha
-    float net_torque = applied_torque - friction_torque;
-
-    DEBUG_PRINTF("J estimation details: dt=%.1fms, v_init=%.3f, v_final=%.3f, acc=%.2f\n",
-           delta_t_ms, initial_velocity, final_velocity, acceleration);
-    DEBUG_PRINTF("T_app=%.4f, T_fric=%.4f, T_net=%.4f\n",
-           applied_torque, friction_torque, net_torque);
-
-
-    if (fabsf(acceleration) > 0.01f) { // Avoid division by zero or noise amplification
-        motor_J = net_torque / acceleration;
-        if (motor_J < 0) { // Inertia should not be negative
-             DEBUG_PRINTF("J estimation resulted in negative value (%.6f) - likely measurement error.\n", motor_J);
-             motor_J = 0.0f;
-        } else {
-            DEBUG_PRINTF("Estimated J: %.6f kg*m^2\n", motor_J);
-        }
+    MechFit fit;
+    MechFitResult res;
+    const float *w = mech_capture_buffer();
+    mech_fit_reset(&fit);
+    ok = ok && mech_fit_add_segment(&fit, w, n_step, MECH_CAPTURE_PERIOD_S, motor_Kt * test_current_step);
+    mech_fit_add_segment(&fit, w + n_step, n_coast, MECH_CAPTURE_PERIOD_S, 0.0f); // Optional, adds B/Tc contrast
+
+    DEBUG_PRINTF("J estimation details: step=%lu, coast=%lu samples at %u Hz\n",
+           (unsigned long)n_step, (unsigned long)n_coast, MECH_CAPTURE_RATE_HZ);
+
+    float params[4] = { test_current_step, motor_Kt, (float)n_step };
+    capture_phase_begin(CAP_PHASE_J, params);
+    capture_velocity(0, MECH_CAPTURE_RATE_HZ, w, n_step + n_coast);
+    if (ok) {
+        ok = estm_J_from_fit(&fit, &res);
     } else {
         motor_J = 0.0f;
-        DEBUG_PRINTF("J estimation failed (acceleration too low or measurement error).\n");
+        DEBUG_PRINTF("J estimation failed (capture timeout or step too short).\n");
     }
+    float results[4] = { ok ? res.J : 0.0f, ok ? res.B : 0.0f, ok ? res.Tc : 0.0f, ok ? res.rms : 0.0f };
+    capture_phase_end(ok, results);
     HAL_Delay(500);
-}
\ No newline at end of file
+}
@@ -3,12 +3,14 @@
 
 #include "main.h"
 #include "motor_params_rl.h" // Need access to motor_R
+#include "motor_params_mech.h" // High-rate velocity capture and J/B/Tc fit
 
 // --- Estimated Parameters (Defined in .c file) ---
 extern float motor_Ke; // Back-EMF Constant (V/(rad/s))
 extern float motor_Kt; // Torque Constant (Nm/A)
 extern float motor_J;  // Inertia (kg*m^2)
 extern float motor_B;  // Viscous Friction (Nm/(rad/s))
+extern float motor_Tc; // Coulomb Friction (Nm)
 
 // --- Placeholder Function Prototypes (Implement these based on your hardware/control) ---
 
@@ -16,13 +18,13 @@ extern float motor_B;  // Viscous Friction (Nm/(rad/s))
  * @brief Reads motor velocity from sensor.
  * @return Velocity in radians per second.
  */
-float read_motor_velocity_rad_s(void);
+float read_velo(void);
 
 /**
  * @brief Reads the actual voltage applied across the motor terminals.
  * @return Voltage in Volts.
  */
-float read_motor_voltage(void);
+float read_Vs(void);
 
 /**
  * @brief Controls the motor to achieve a target current. (Placeholder)
@@ -39,26 +41,50 @@ void DC_Ctl_Velo(float target_velocity_rad_s);
 
 // --- Public Function Prototypes ---
 
+/**
+ * @brief Computes Ke = |V - I*R| / w at a steady speed and sets motor_Kt = motor_Ke.
+ * @note The last step of estm_Ke_Kt(), shared with the estimation sequence.
+ * @return false (Ke = Kt = 0) if the velocity is too low to divide by.
+ */
+bool estm_Ke_from_steady(float steady_voltage, float steady_current, float steady_velocity);
+
+/**
+ * @brief Motor torque Kt * |I| holding a steady speed against friction.
+ * @note Shared by estm_Bm() and the friction sweep of the estimation sequence.
+ */
+float estm_steady_torque(float steady_current);
+
+/**
+ * @brief Solves the J/B/Tc fit and stores motor_J (motor_B, motor_Tc unless a friction map is valid).
+ * @note The last step of estm_Jm(), shared with the estimation sequence.
+ * @return false (motor_J = 0) if the fit is singular (too little motion).
+ */
+bool estm_J_from_fit(const MechFit *fit, MechFitResult *res);
+
 /**
  * @brief Estimates Back-EMF constant Ke (and assumes Kt = Ke).
  * @note Requires motor shaft to be UNLOCKED and motor_R estimated.
  * @param test_velocity_rad_s Target velocity for the test.
  */
-void estimate_Ke_Kt(float test_velocity_rad_s);
+void estm_Ke_Kt(float test_velocity_rad_s);
 
 /**
  * @brief Estimates viscous friction coefficient B.
  * @note Requires motor shaft to be UNLOCKED and motor_Kt estimated.
+ *       Single point through the origin; the sequencer's speed sweep (motor_params_friction.h)
+ *       also separates Coulomb and Stribeck friction.
  * @param test_velocity_rad_s Target velocity for the test.
  */
-void estimate_B(float test_velocity_rad_s);
+void estm_Bm(float test_velocity_rad_s);
 
 /**
- * @brief Estimates motor inertia J using a current step.
- * @note Requires motor shaft to be UNLOCKED and motor_Kt, motor_B estimated.
+ * @brief Estimates inertia J, viscous friction B and Coulomb friction Tc in one run.
+ * @note Requires motor shaft to be UNLOCKED and motor_Kt estimated.
+ *       Captures velocity at MECH_CAPTURE_RATE_HZ during a current step and the free
+ *       coast-down after it, then least-squares fits the whole w(t) curve.
  * @param test_current_step Current step to apply in Amps.
  */
-void estimate_J(float test_current_step);
+void estm_Jm(float test_current_step);
 
 
 #endif /* INC_MOTOR_PARAMS_JB_H_ */
\ No newline at end of file
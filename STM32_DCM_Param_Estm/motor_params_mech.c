@@ -0,0 +1,179 @@
+#include "motor_params_mech.h"
+#include <math.h>
+#include "motor_params_jb.h" // read_velo
+
+// --- Capture State ---
+// Written by the TIM1 update ISR while armed, read by the fit afterwards
+static float capture_buf[MECH_CAPTURE_LEN];
+static volatile bool capture_armed = false;
+static volatile uint32_t capture_count = 0;
+static uint32_t capture_offset = 0;
+static uint32_t capture_max = 0;
+static uint32_t capture_decim = 0;
+static float capture_stop_velocity = 0.0f;
+
+// --- Velocity Capture ---
+
+void mech_capture_start(uint32_t offset, uint32_t max_samples, float stop_velocity) {
+    if (offset >= MECH_CAPTURE_LEN) offset = MECH_CAPTURE_LEN;
+    if (max_samples > MECH_CAPTURE_LEN - offset) max_samples = MECH_CAPTURE_LEN - offset;
+
+    capture_armed = false;
+    capture_offset = offset;
+    capture_max = max_samples;
+    capture_stop_velocity = stop_velocity;
+    capture_decim = 0;
+    capture_count = 0;
+    capture_armed = (max_samples > 0);
+}
+
+void mech_capture_stop(void) {
+    capture_armed = false;
+}
+
+bool mech_capture_done(void) {
+    return !capture_armed;
+}
+
+uint32_t mech_capture_count(void) {
+    return capture_count;
+}
+
+const float *mech_capture_buffer(void) {
+    return capture_buf;
+}
+
+void mech_capture_tick(void) {
+    if (!capture_armed) return;
+    if (++capture_decim < MECH_CAPTURE_DECIM) return;
+    capture_decim = 0;
+
+    float w = read_velo();
+    capture_buf[capture_offset + capture_count] = w;
+    capture_count++;
+    if (capture_count >= capture_max ||
+        (capture_stop_velocity > 0.0f && fabsf(w) < capture_stop_velocity)) {
+        capture_armed = false;
+    }
+}
+
+// --- Least-Squares Fit ---
+
+void mech_fit_reset(MechFit *fit) {
+    for (uint8_t i = 0; i < MECH_FIT_PARAMS; i++) {
+        for (uint8_t j = 0; j < MECH_FIT_PARAMS; j++) fit->ata[i][j] = 0.0;
+        fit->atb[i] = 0.0;
+    }
+    fit->yty = 0.0;
+    fit->rows = 0;
+    fit->segments = 0;
+    fit->seg_n = 0;
+    fit->seg_k = 0;
+}
+
+bool mech_fit_add_segment(MechFit *fit, const float *w, uint32_t n, float dt, float torque) {
+    if (!mech_fit_begin_segment(fit, w, n, dt, torque)) return false;
+    mech_fit_step(fit, n);
+    return true;
+}
+
+bool mech_fit_begin_segment(MechFit *fit, const float *w, uint32_t n, float dt, float torque) {
+    if (n < 3 || fit->segments >= MECH_FIT_SEGMENTS || fit->seg_k < fit->seg_n) return false;
+
+    // Direction of motion for the Coulomb term (constant within a segment); single precision
+    // keeps this pass cheap, only a sum within rounding of zero could flip it
+    float sum = 0.0f;
+    for (uint32_t k = 0; k < n; k++) sum += w[k];
+    fit->seg_s = (sum >= 0.0f) ? 1.0 : -1.0;
+    if (fabsf(sum) < 1e-9f && torque != 0.0f) fit->seg_s = (torque > 0.0f) ? 1.0 : -1.0;
+
+    fit->seg_w = w;
+    fit->seg_n = n;
+    fit->seg_k = 0;
+    fit->seg_dt = dt;
+    fit->seg_torque = torque;
+    fit->seg_integral = 0.0; // Trapezoid integral of w from the first sample
+    return true;
+}
+
+bool mech_fit_step(MechFit *fit, uint32_t max_rows) {
+    if (fit->seg_k >= fit->seg_n) return true;
+
+    const float *w = fit->seg_w;
+    uint8_t w0_col = (uint8_t)(3U + fit->segments);
+    uint32_t end = (fit->seg_n - fit->seg_k > max_rows) ? fit->seg_k + max_rows : fit->seg_n;
+    for (uint32_t k = fit->seg_k; k < end; k++) {
+        double t = (double)k * fit->seg_dt;
+        if (k > 0) fit->seg_integral += 0.5 * ((double)w[k - 1] + (double)w[k]) * fit->seg_dt;
+
+        double phi[MECH_FIT_PARAMS] = { 0.0 };
+        phi[0] = fit->seg_torque * t;
+        phi[1] = fit->seg_integral;
+        phi[2] = fit->seg_s * t;
+        phi[w0_col] = 1.0;
+        double y = w[k];
+
+        for (uint8_t i = 0; i < MECH_FIT_PARAMS; i++) {
+            if (phi[i] == 0.0) continue;
+            for (uint8_t j = 0; j < MECH_FIT_PARAMS; j++) fit->ata[i][j] += phi[i] * phi[j];
+            fit->atb[i] += phi[i] * y;
+        }
+        fit->yty += y * y;
+    }
+    fit->rows += end - fit->seg_k;
+    fit->seg_k = end;
+    if (end < fit->seg_n) return false;
+    fit->segments++;
+    return true;
+}
+
+bool mech_fit_solve(const MechFit *fit, MechFitResult *result) {
+    uint8_t n = (uint8_t)(3U + fit->segments);
+    double a[MECH_FIT_PARAMS][MECH_FIT_PARAMS + 1];
+    double theta[MECH_FIT_PARAMS] = { 0.0 };
+
+    if (fit->segments == 0 || fit->rows <= n) return false;
+
+    // Gaussian elimination with partial pivoting on [A'A | A'y]
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++) a[i][j] = fit->ata[i][j];
+        a[i][n] = fit->atb[i];
+    }
+    for (uint8_t c = 0; c < n; c++) {
+        uint8_t p = c;
+        for (uint8_t r = c + 1; r < n; r++) {
+            if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+        }
+        if (fabs(a[p][c]) < 1e-18) return false; // Not excited (e.g. no torque segment)
+        if (p != c) {
+            for (uint8_t j = c; j <= n; j++) {
+                double tmp = a[c][j];
+                a[c][j] = a[p][j];
+                a[p][j] = tmp;
+            }
+        }
+        for (uint8_t r = c + 1; r < n; r++) {
+            double f = a[r][c] / a[c][c];
+            for (uint8_t j = c; j <= n; j++) a[r][j] -= f * a[c][j];
+        }
+    }
+    for (int8_t i = (int8_t)(n - 1); i >= 0; i--) {
+        double v = a[i][n];
+        for (uint8_t j = (uint8_t)(i + 1); j < n; j++) v -= a[i][j] * theta[j];
+        theta[i] = v / a[i][i];
+    }
+
+    if (theta[0] <= 0.0) return false; // 1/J must be positive
+
+    // Residual: y'y - theta'A'y
+    double sse = fit->yty;
+    for (uint8_t i = 0; i < n; i++) sse -= theta[i] * fit->atb[i];
+    if (sse < 0.0) sse = 0.0;
+
+    double J = 1.0 / theta[0];
+    result->J = (float)J;
+    result->B = (float)(-theta[1] * J);
+    result->Tc = (float)(-theta[2] * J);
+    result->rms = (float)sqrt(sse / fit->rows);
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef INC_MOTOR_PARAMS_MECH_H_
+#define INC_MOTOR_PARAMS_MECH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "motor_adc.h" // PWM_FREQ_HZ
+
+// --- Velocity Capture Configuration ---
+#define MECH_CAPTURE_DECIM 10U                                  // PWM periods per velocity sample
+#define MECH_CAPTURE_RATE_HZ (PWM_FREQ_HZ / MECH_CAPTURE_DECIM) // 2 kHz
+#define MECH_CAPTURE_PERIOD_S (1.0f / (float)MECH_CAPTURE_RATE_HZ)
+#define MECH_CAPTURE_LEN 1024U                                  // Samples for step + coast-down (512 ms)
+#define MECH_STEP_MS 50U                                        // Torque step duration
+#define MECH_STEP_SAMPLES (MECH_STEP_MS * MECH_CAPTURE_RATE_HZ / 1000U)
+#define MECH_STOP_VELOCITY 0.2f                                 // Coast-down capture ends below this |w| (rad/s)
+
+// --- Mechanical Model Fit ---
+// J*dw/dt = T - B*w - Tc*sign(w), integrated over each segment so no velocity is differentiated:
+//   w(t) = w0 + (T*t - B*int(w) - Tc*s*t) / J
+// Linear in theta = [1/J, -B/J, -Tc/J, w0_seg0, w0_seg1]; every sample of every segment is one row.
+// host/mech_check compares its J spread with the old two-point estm_Jm() on synthetic noisy runs.
+#define MECH_FIT_SEGMENTS 2U
+#define MECH_FIT_PARAMS (3U + MECH_FIT_SEGMENTS)
+
+// Accumulated in double: the columns span several decades and a one-off fit can afford it,
+// if not in one go: mech_fit_step() adds a segment a few rows at a time
+typedef struct {
+    double ata[MECH_FIT_PARAMS][MECH_FIT_PARAMS]; // Normal equations A'A
+    double atb[MECH_FIT_PARAMS];                  // A'y
+    double yty;                                   // y'y (residual)
+    uint32_t rows;
+    uint8_t segments;
+    // Segment being added (seg_k == seg_n when none)
+    const float *seg_w;
+    uint32_t seg_n;
+    uint32_t seg_k;
+    double seg_dt;
+    double seg_torque;
+    double seg_s;                                 // Direction of motion (Coulomb sign)
+    double seg_integral;                          // Trapezoid integral of w up to seg_k - 1
+} MechFit;
+
+typedef struct {
+    float J;   // Inertia (kg*m^2)
+    float B;   // Viscous friction (Nm/(rad/s))
+    float Tc;  // Coulomb friction (Nm)
+    float rms; // Residual velocity RMS (rad/s)
+} MechFitResult;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Arms the velocity capture; samples land in the capture buffer from the TIM1 update ISR.
+ * @param offset First buffer index to write (segments are appended back to back).
+ * @param max_samples Samples to capture before stopping.
+ * @param stop_velocity Capture also ends once |w| drops below this (0 disables).
+ */
+void mech_capture_start(uint32_t offset, uint32_t max_samples, float stop_velocity);
+
+/**
+ * @brief Stops the capture early.
+ */
+void mech_capture_stop(void);
+
+/**
+ * @brief True once the armed capture has finished.
+ */
+bool mech_capture_done(void);
+
+/**
+ * @brief Samples captured by the current (or last) segment.
+ */
+uint32_t mech_capture_count(void);
+
+/**
+ * @brief Capture buffer (MECH_CAPTURE_LEN samples, rad/s).
+ */
+const float *mech_capture_buffer(void);
+
+/**
+ * @brief Takes one velocity sample every MECH_CAPTURE_DECIM PWM periods while armed.
+ * @note Call from the TIM1 update interrupt.
+ */
+void mech_capture_tick(void);
+
+/**
+ * @brief Clears the accumulated fit.
+ */
+void mech_fit_reset(MechFit *fit);
+
+/**
+ * @brief Adds one constant-torque segment of uniformly sampled velocity to the fit.
+ * @param w Velocity samples (rad/s).
+ * @param n Number of samples.
+ * @param dt Sample period (s).
+ * @param torque Applied motor torque during the segment (Nm), 0 for coast-down.
+ * @return false if the segment is too short or MECH_FIT_SEGMENTS are already in.
+ */
+bool mech_fit_add_segment(MechFit *fit, const float *w, uint32_t n, float dt, float torque);
+
+/**
+ * @brief Starts adding a segment in steps (same arguments as mech_fit_add_segment()).
+ * @note Nothing is accumulated yet; the samples must stay valid until mech_fit_step() is done.
+ * @return false if the segment is too short, MECH_FIT_SEGMENTS are already in or one is in progress.
+ */
+bool mech_fit_begin_segment(MechFit *fit, const float *w, uint32_t n, float dt, float torque);
+
+/**
+ * @brief Adds up to max_rows samples of the segment begun last.
+ * @note About 25 double multiply-adds per row, soft-float on the F407.
+ * @return true once the segment is complete (or none is in progress).
+ */
+bool mech_fit_step(MechFit *fit, uint32_t max_rows);
+
+/**
+ * @brief Solves the accumulated fit for J, B and Tc.
+ * @note At least one segment must have a non-zero torque to fix the scale of J.
+ * @return false if the system is singular or the result is not physical (J <= 0).
+ */
+bool mech_fit_solve(const MechFit *fit, MechFitResult *result);
+
+#endif /* INC_MOTOR_PARAMS_MECH_H_ */
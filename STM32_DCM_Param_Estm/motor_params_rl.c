@@ -1,64 +1,75 @@
 #include "motor_params_rl.h"
 #include <math.h>
-#include "debug.h" // Include the debug print header
+#include "motor_log.h" // DEBUG_PRINTF (deferred binary log over RTT)
+#include "motor_lockin.h" // Synchronous demodulation impedance measurement
+#include "motor_capture.h" // Raw sample capture of estimation phases
+#include "motor_current_loop.h" // Released by voltage-mode output
+#include "motor_bridge.h" // Signed H-bridge output
+#include "fxp_math.h" // Integer sine (Common/)
 
 // --- Estimated Parameters (Definition) ---
 float motor_R = 0.0f;
 float motor_L = 0.0f;
 
+// Number of stream samples in one millisecond
+#define SAMPLES_PER_MS (ADC_SAMPLE_RATE_HZ / 1000U)
+
 // --- Internal Helper Functions ---
 
 // Function to set motor voltage via PWM
-static void set_Vs(float voltage) {
-    if (voltage < 0.0f) voltage = 0.0f;
+void set_Vs(float voltage) {
+    current_loop_disable(); // Voltage mode: the current loop must not overwrite the compare
+    if (voltage < -V_SUPPLY) voltage = -V_SUPPLY;
     if (voltage > V_SUPPLY) voltage = V_SUPPLY;
-    // Calculate max duty based on the specific timer instance
-    uint32_t pwm_max_duty = (htim1.Instance->ARR);
-    uint32_t duty = (uint32_t)((voltage / V_SUPPLY) * pwm_max_duty);
-    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, duty);
+    // Signed: the H-bridge reverses the winding voltage for negative values
+    bridge_write(bridge_volts_to_counts(voltage));
+    capture_voltage(adc_stream_position(), voltage);
 }
 
-// Function to read ADC value and convert to current
-static float set_Is() {
-    uint32_t adc_value = 0;
-    // Assuming ADC is configured for single conversion, software trigger
-    HAL_ADC_Start(&hadc1);
-    if (HAL_ADC_PollForConversion(&hadc1, 10) == HAL_OK) {
-        adc_value = HAL_ADC_GetValue(&hadc1);
-    }
-    HAL_ADC_Stop(&hadc1); // Stop ADC after conversion
+// --- Public Functions ---
 
-    float voltage_at_shunt = ((float)adc_value / ADC_RESOLUTION) * V_REF;
-    // Adjust calculation if using an amplifier for current sense
-    float current = voltage_at_shunt / SHUNT_RESISTOR;
-    return current;
+float read_motor_current(void) {
+    adc_stream_flush(); // Only samples taken from now on
+    return adc_stream_mean_current(SAMPLES_PER_MS);
 }
 
-// --- Public Functions ---
+bool estm_R_from_steady(float test_voltage, float steady_current) {
+    if (steady_current <= 0.01f) { // Avoid division by zero/small numbers
+        motor_R = 0.0f; // Indicate error or invalid measurement
+        DEBUG_PRINTF("Resistance estimation failed (current too low).\n");
+        return false;
+    }
+    motor_R = test_voltage / steady_current;
+    DEBUG_PRINTF("Estimated R: %.4f Ohms\n", motor_R);
+    return true;
+}
+
+bool estm_L_from_reactance(float z_im, float frequency_hz) {
+    if (z_im <= 0.0f || frequency_hz <= 0.0f) {
+        motor_L = 0.0f; // Error: a winding cannot be capacitive
+        DEBUG_PRINTF("Inductance estimation failed: non-inductive reactance.\n");
+        return false;
+    }
+    motor_L = z_im / (2.0f * M_PI * frequency_hz);
+    DEBUG_PRINTF("Estimated L: %.6f H\n", motor_L);
+    return true;
+}
 
 void estm_Rs(float test_voltage) {
+    float params[4] = { test_voltage };
     DEBUG_PRINTF("Estimating R (Shaft LOCKED!). Applying %.2fV...\n", test_voltage);
+    capture_phase_begin(CAP_PHASE_R, params);
     set_Vs(test_voltage);
     HAL_Delay(1000); // Wait for current to stabilize
 
-    float steady_current = 0.0f;
-    int samples = 10;
-    for (int i = 0; i < samples; i++) {
-        steady_current += set_Is();
-        HAL_Delay(10); // Small delay between samples
-    }
-    steady_current /= samples;
+    // Average 100 ms of PWM-synchronous samples (2000 samples at 20 kHz)
+    adc_stream_flush();
+    float steady_current = adc_stream_mean_current(100U * SAMPLES_PER_MS);
 
     set_Vs(0); // Turn off motor
     DEBUG_PRINTF("Steady current measured: %.3f A\n", steady_current);
-
-    if (steady_current > 0.01f) { // Avoid division by zero/small numbers
-        motor_R = test_voltage / steady_current;
-        DEBUG_PRINTF("Estimated R: %.4f Ohms\n", motor_R);
-    } else {
-        motor_R = 0.0f; // Indicate error or invalid measurement
-        DEBUG_PRINTF("Resistance estimation failed (current too low).\n");
-    }
+    bool ok = estm_R_from_steady(test_voltage, steady_current);
+    capture_phase_end(ok, &motor_R);
 }
 
 void estm_Ls(float test_voltage) {
@@ -67,36 +78,44 @@ void estm_Ls(float test_voltage) {
         return;
     }
     DEBUG_PRINTF("Estimating L (Shaft LOCKED!). Applying %.2fV step...\n", test_voltage);
+    float params[4] = { test_voltage, motor_R };
+    capture_phase_begin(CAP_PHASE_L_STEP, params);
 
     set_Vs(0);
     HAL_Delay(500); // Ensure motor is off
 
-    uint32_t start_time = HAL_GetTick();
+    adc_stream_flush(); // Sample 0 is the first conversion after the step
     set_Vs(test_voltage);
 
-    float current = 0.0f;
     // Target current is 63.2% of the final steady-state current (V/R)
     float target_current = (test_voltage / motor_R) * (1.0f - expf(-1.0f));
-    uint32_t time_at_target = 0;
-    uint32_t timeout_ms = 500; // Timeout for the measurement
+    uint32_t time_at_target = 0; // Sample index + 1 at which the target was reached (0 = not reached)
+    uint32_t timeout_samples = 500U * SAMPLES_PER_MS; // Timeout for the measurement
+    uint16_t block[32];
 
     DEBUG_PRINTF("Target current for L (63.2%%): %.3f A\n", target_current);
 
-    while (HAL_GetTick() - start_time < timeout_ms) {
-        current = set_Is();
-        if (current >= target_current) {
-            time_at_target = HAL_GetTick();
-            break;
+    // Compare in raw counts, no per-sample float conversion
+    float target_counts = target_current * SHUNT_RESISTOR / V_REF * ADC_RESOLUTION + ADC_CURRENT_OFFSET;
+    uint16_t target_raw = (target_counts > ADC_RESOLUTION - 1) ? ADC_RESOLUTION - 1 : (uint16_t)target_counts;
+
+    while (time_at_target == 0 && adc_stream_index() < timeout_samples) {
+        uint32_t base = adc_stream_index();
+        if (!adc_stream_read_block(block, 32, 10)) break;
+        for (uint32_t i = 0; i < 32; i++) {
+            if (block[i] >= target_raw) {
+                time_at_target = base + i + 1;
+                break;
+            }
         }
-        // A small delay might be needed if ADC sampling is very fast
-        // HAL_Delay(1);
     }
 
     set_Vs(0); // Turn off motor
 
     if (time_at_target > 0) {
-        float time_constant_ms = (float)(time_at_target - start_time);
-        float time_constant_s = time_constant_ms / 1000.0f;
+        // Sample k is taken k+1 PWM periods after the step was written
+        float time_constant_s = (float)time_at_target * ADC_SAMPLE_PERIOD_S;
+        float time_constant_ms = time_constant_s * 1000.0f;
         motor_L = motor_R * time_constant_s; // Time constant Tau = L/R
         DEBUG_PRINTF("Time to reach target current: %.1f ms\n", time_constant_ms);
         DEBUG_PRINTF("Estimated L: %.6f H\n", motor_L);
@@ -104,6 +123,8 @@ void estm_Ls(float test_voltage) {
         motor_L = 0.0f; // Indicate error or timeout
         DEBUG_PRINTF("Inductance estimation failed (timeout or current didn't reach target).\n");
     }
+    float results[4] = { motor_L, (float)time_at_target * ADC_SAMPLE_PERIOD_S };
+    capture_phase_end(time_at_target > 0, results);
 }
 
 /**
@@ -128,45 +149,51 @@ void estm_Ls(float test_voltage) {
 
     DEBUG_PRINTF("Estimating L (Shaft LOCKED!) using Sine Wave...\n");
     DEBUG_PRINTF("Applying %.2fV amplitude at %.1f Hz...\n", test_voltage_amplitude, frequency_hz);
+    float params[4] = { test_voltage_amplitude, frequency_hz, motor_R };
+    float impedance_Z = 0.0f;
+    capture_phase_begin(CAP_PHASE_L_SINE, params);
 
-    // Angular frequency
+    // Angular frequency, and the phase step per ADC sample (2^32 = one turn)
     float omega = 2.0f * M_PI * frequency_hz;
+    uint32_t phase_step = fxp_phase_step((uint32_t)(frequency_hz * FXP_ONE), ADC_SAMPLE_RATE_HZ);
 
     // Duration of the test - apply for a few cycles
-    uint32_t duration_ms = (uint32_t)(5.0f / frequency_hz * 1000.0f); // 5 cycles
-    if (duration_ms < 500) duration_ms = 500; // Minimum duration
+    // Both half-waves are measured now, so 3 cycles do what 5 of the rectified sine did
+    uint32_t duration_ms = (uint32_t)(3.0f / frequency_hz * 1000.0f); // 3 cycles
+    if (duration_ms < 250) duration_ms = 250; // Minimum duration
     if (duration_ms > 5000) duration_ms = 5000; // Maximum duration
 
-    DEBUG_PRINTF("Test duration: %lu ms\n", duration_ms);
+    DEBUG_PRINTF("Test duration: %lu ms\n", (unsigned long)duration_ms);
 
     float max_current_amplitude = 0.0f;
-    uint32_t start_time = HAL_GetTick();
-    uint32_t current_time = 0;
+    uint16_t max_raw = 0;
+    uint16_t min_raw = ADC_RESOLUTION - 1;
+    uint32_t duration_samples = duration_ms * SAMPLES_PER_MS;
+    uint16_t block[SAMPLES_PER_MS];
+
+    adc_stream_flush(); // Sample index is the time base of the sine
 
     // --- Apply Sinusoidal Voltage and Measure Current ---
-    while ((current_time = HAL_GetTick()) - start_time < duration_ms) {
-        // Calculate instantaneous voltage based on sine wave
-        float time_s = (float)(current_time - start_time) / 1000.0f;
-        float instantaneous_voltage = test_voltage_amplitude * sinf(omega * time_s);
-
-        // Apply the voltage (ensure it's positive for simple PWM)
-        // This applies a rectified sine wave if only one PWM channel is used.
-        // For a true sine wave across H-bridge, control logic is more complex.
-        // We assume the positive half-cycle is sufficient if V_amplitude <= V_SUPPLY.
-        set_Vs(instantaneous_voltage > 0 ? instantaneous_voltage : 0);
-
-        // Measure instantaneous current
-        float current = set_Is();
-
-        // Track the peak current - simple peak detection
-        if (current > max_current_amplitude) {
-            max_current_amplitude = current;
+    // The voltage is updated once per block of samples (1 ms); the sample index
+    // gives the exact elapsed time, independent of loop jitter.
+    while (adc_stream_index() < duration_samples) {
+        // Calculate instantaneous voltage based on sine wave: the sample index times the step
+        // is the exact phase, no float time that loses resolution as the test runs
+        int32_t sine = fxp_sin(adc_stream_index() * phase_step);
+        float instantaneous_voltage = test_voltage_amplitude * (float)sine * (1.0f / FXP_ONE);
+
+        // Apply the voltage: the full signed sine across the H-bridge
+        set_Vs(instantaneous_voltage);
+
+        // Measure current at every PWM period of the block and track both peaks
+        if (!adc_stream_read_block(block, SAMPLES_PER_MS, 10)) break;
+        for (uint32_t i = 0; i < SAMPLES_PER_MS; i++) {
+            if (block[i] > max_raw) max_raw = block[i];
+            if (block[i] < min_raw) min_raw = block[i];
         }
-
-        // Small delay to allow PWM cycle and ADC conversion, adjust as needed
-        // This delay affects the effective sine wave frequency if too large.
-        HAL_Delay(1);
     }
+    // Half the peak-to-peak: the sense offset cancels
+    max_current_amplitude = (max_raw > min_raw) ? 0.5f * (adc_raw_to_current(max_raw) - adc_raw_to_current(min_raw)) : 0.0f;
 
     set_Vs(0); // Turn off motor
     DEBUG_PRINTF("Maximum current amplitude measured: %.3f A\n", max_current_amplitude);
@@ -174,7 +201,7 @@ void estm_Ls(float test_voltage) {
     // --- Calculate Inductance ---
     if (max_current_amplitude > 0.01f) {
         // Calculate impedance Z = V_amplitude / I_amplitude
-        float impedance_Z = test_voltage_amplitude / max_current_amplitude;
+        impedance_Z = test_voltage_amplitude / max_current_amplitude;
         DEBUG_PRINTF("Calculated Impedance (Z): %.4f Ohms\n", impedance_Z);
 
         // Ensure Z is not less than R (physically impossible)
@@ -195,5 +222,84 @@ void estm_Ls(float test_voltage) {
         motor_L = 0.0f; // Indicate error or invalid measurement
         DEBUG_PRINTF("Inductance estimation failed (current amplitude too low).\n");
     }
+    float results[4] = { motor_L, impedance_Z };
+    capture_phase_end(motor_L > 0.0f, results);
+}
+
+/**
+ * @brief Estimates motor inductance (Ls) by synchronous demodulation.
+ * @note Requires motor shaft to be LOCKED. Does not need motor_R: the resistive and
+ *       reactive parts of Z come out of the same measurement, and L = Im(Z) / omega.
+ *       Test time is (LOCKIN_SETTLE_CYCLES + cycles) / frequency_hz (60 ms at 100 Hz, 4 cycles).
+ * @param test_voltage_amplitude Amplitude of the sine voltage (Volts), applied on a DC offset of the same size.
+ * @param frequency_hz Frequency of the sine wave (Hz).
+ * @param cycles Number of excitation cycles to correlate over.
+ */
+void estm_Ls_lockin(float test_voltage_amplitude, float frequency_hz, uint32_t cycles) {
+    LockinResult z;
+    float params[4] = { test_voltage_amplitude, frequency_hz, (float)cycles };
+
+    DEBUG_PRINTF("Estimating L (Shaft LOCKED!) using lock-in demodulation...\n");
+    DEBUG_PRINTF("Applying %.2fV amplitude at %.1f Hz for %lu cycles...\n",
+                 test_voltage_amplitude, frequency_hz, (unsigned long)cycles);
+
+    capture_phase_begin(CAP_PHASE_L_LOCKIN, params);
+    if (!lockin_measure(test_voltage_amplitude, frequency_hz, cycles, &z)) {
+        motor_L = 0.0f; // Indicate error or invalid measurement
+        DEBUG_PRINTF("Inductance estimation failed (invalid parameters, sample overrun or no current).\n");
+        capture_phase_end(false, NULL);
+        return;
+    }
+
+    DEBUG_PRINTF("I_dc=%.3f A, I=%.4f%+.4fj A over %lu samples\n", z.i_dc, z.i_re, z.i_im, (unsigned long)z.samples);
+    DEBUG_PRINTF("Z = %.4f %+.4fj Ohms at %.2f Hz\n", z.z_re, z.z_im, z.frequency_hz);
+
+    DEBUG_PRINTF("AC resistance: %.4f Ohms (DC estimate %.4f Ohms)\n", z.z_re, motor_R);
+
+    bool ok = estm_L_from_reactance(z.z_im, z.frequency_hz);
+    float results[4] = { motor_L, z.z_re, z.z_im, z.frequency_hz };
+    capture_phase_end(ok, results);
 }
 
+/**
+ * @brief Estimates R and L from an impedance spectrum measured with one multisine window.
+ * @note Requires motor shaft to be LOCKED. Sets motor_R and motor_L to the fitted values
+ *       extrapolated to DC; the slopes show frequency dependence from eddy currents.
+ *       Test time is (LOCKIN_SETTLE_CYCLES + periods) * MULTISINE_PERIOD samples (205 ms for 2 periods).
+ * @param test_voltage_amplitude Peak AC voltage (Volts), applied on a DC offset of the same size.
+ * @param f_min_hz Lowest tone (Hz).
+ * @param f_max_hz Highest tone (Hz).
+ */
+void estm_RL_spectrum(float test_voltage_amplitude, float f_min_hz, float f_max_hz) {
+    ImpedanceSpectrum z;
+    float params[4] = { test_voltage_amplitude, f_min_hz, f_max_hz, 8.0f };
+
+    DEBUG_PRINTF("Estimating R/L spectrum (Shaft LOCKED!) with multisine %.0f-%.0f Hz, %.2fV peak...\n",
+                 f_min_hz, f_max_hz, test_voltage_amplitude);
+
+    capture_phase_begin(CAP_PHASE_RL_SPECTRUM, params);
+    if (!multisine_measure(test_voltage_amplitude, f_min_hz, f_max_hz, (uint8_t)params[3], 2, &z)) {
+        DEBUG_PRINTF("Spectrum estimation failed (invalid parameters, sample overrun or no current).\n");
+        capture_phase_end(false, NULL);
+        return;
+    }
+    float results[4] = { z.R0, z.L0, z.R_slope, z.L_slope };
+
+    DEBUG_PRINTF("Crest factor %.2f, %u tones, %lu samples\n", z.crest_factor, z.tones, (unsigned long)z.samples);
+    for (uint8_t k = 0; k < z.tones; k++) {
+        float omega = 2.0f * M_PI * z.point[k].frequency_hz;
+        DEBUG_PRINTF("  f=%7.1f Hz  Z=%.4f %+.4fj Ohms  L=%.6f H\n",
+                     z.point[k].frequency_hz, z.point[k].z_re, z.point[k].z_im, z.point[k].z_im / omega);
+    }
+    DEBUG_PRINTF("Fit: R(f) = %.4f %+.3e*f Ohms, L(f) = %.6f %+.3e*f H\n", z.R0, z.R_slope, z.L0, z.L_slope);
+
+    if (z.R0 <= 0.0f || z.L0 <= 0.0f) {
+        DEBUG_PRINTF("Spectrum fit rejected (non-physical R0 or L0).\n");
+        capture_phase_end(false, results);
+        return;
+    }
+    capture_phase_end(true, results);
+    motor_R = z.R0;
+    motor_L = z.L0;
+    DEBUG_PRINTF("Estimated R: %.4f Ohms, L: %.6f H\n", motor_R, motor_L);
+}
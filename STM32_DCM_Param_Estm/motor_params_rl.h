@@ -2,6 +2,7 @@
 #define INC_MOTOR_PARAMS_RL_H_
 
 #include "main.h" // Include main HAL types
+#include "motor_adc.h" // Timer-triggered DMA current sampling
 
 // --- External Peripheral Handles (Required by the module) ---
 extern TIM_HandleTypeDef htim1; // Timer for PWM
@@ -9,9 +10,7 @@ extern ADC_HandleTypeDef hadc1; // ADC for measurements
 
 // --- Constants used by RL estimation ---
 #define V_SUPPLY 12.0f       // Motor supply voltage (Volts)
-#define ADC_RESOLUTION 4096 // 12-bit ADC
-#define V_REF 3.3f          // ADC reference voltage (Volts)
-#define SHUNT_RESISTOR 0.1f // Shunt resistor value for current sensing (Ohms)
+// Current sense constants (ADC_RESOLUTION, V_REF, SHUNT_RESISTOR) live in motor_adc.h
 // Note: PWM_MAX_DUTY depends on htim1, calculated internally
 
 // --- Estimated Parameters (Defined in .c file) ---
@@ -25,13 +24,66 @@ extern float motor_L; // Estimated Inductance (Henrys)
  * @note Requires motor shaft to be LOCKED.
  * @param test_voltage Voltage to apply during the test.
  */
-void estimate_resistance(float test_voltage);
+void estm_Rs(float test_voltage);
 
 /**
  * @brief Estimates motor inductance (L).
  * @note Requires motor shaft to be LOCKED and motor_R to be estimated first.
  * @param test_voltage Voltage step to apply during the test.
  */
-void estimate_inductance(float test_voltage);
+void estm_Ls(float test_voltage);
+
+/**
+ * @brief Estimates motor inductance (Ls) using sinusoidal voltage input.
+ * @note Requires motor shaft to be LOCKED and motor_R to be estimated first.
+ * @param test_voltage_amplitude Amplitude of the sine voltage to apply (Volts).
+ * @param frequency_hz Frequency of the sine wave (Hz).
+ */
+void estm_Ls_sine(float test_voltage_amplitude, float frequency_hz);
+
+/**
+ * @brief Estimates motor inductance (Ls) by synchronous (lock-in) demodulation.
+ * @note Requires motor shaft to be LOCKED; see motor_lockin.h.
+ * @param test_voltage_amplitude Amplitude of the sine voltage to apply (Volts).
+ * @param frequency_hz Frequency of the sine wave (Hz).
+ * @param cycles Number of excitation cycles to correlate over.
+ */
+void estm_Ls_lockin(float test_voltage_amplitude, float frequency_hz, uint32_t cycles);
+
+/**
+ * @brief Estimates R and L across frequency from one multisine excitation window.
+ * @note Requires motor shaft to be LOCKED; see multisine_measure() in motor_lockin.h.
+ * @param test_voltage_amplitude Peak AC voltage to apply (Volts).
+ * @param f_min_hz Lowest tone (Hz).
+ * @param f_max_hz Highest tone (Hz).
+ */
+void estm_RL_spectrum(float test_voltage_amplitude, float f_min_hz, float f_max_hz);
+
+/**
+ * @brief Computes R = V / I from a settled current and stores it in motor_R.
+ * @note The last step of estm_Rs(), shared with the estimation sequence.
+ * @return false (motor_R = 0) if the current is too low to divide by.
+ */
+bool estm_R_from_steady(float test_voltage, float steady_current);
+
+/**
+ * @brief Computes L = Im(Z) / omega and stores it in motor_L.
+ * @note The last step of estm_Ls_lockin(), shared with the estimation sequence.
+ * @return false (motor_L = 0) if the reactance is not inductive.
+ */
+bool estm_L_from_reactance(float z_im, float frequency_hz);
+
+/**
+ * @brief Sets the average motor voltage through the PWM duty (clamped to 0..V_SUPPLY).
+ * @param voltage Voltage in Volts.
+ */
+void set_Vs(float voltage);
+
+/**
+ * @brief Reads the motor current averaged over one millisecond of samples.
+ * @note Requires the ADC sample stream to be running (adc_stream_start()).
+ * @return Current in Amps.
+ */
+float read_motor_current(void);
 
 #endif /* INC_MOTOR_PARAMS_RL_H_ */
\ No newline at end of file
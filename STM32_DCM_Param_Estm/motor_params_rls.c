@@ -0,0 +1,109 @@
+#include "motor_params_rls.h"
+#include <math.h>
+#include <stddef.h>
+#include "motor_params_rl.h" // motor_R, motor_L
+#include "motor_params_jb.h" // motor_Ke, motor_Kt, motor_J, motor_B, motor_Tc
+
+// --- Online Estimator State ---
+static RlsEstimator rls_elec; // theta = [R, Ke]
+static RlsEstimator rls_mech; // theta = [J, B, Tc]
+static float prev_current = 0.0f;
+static float prev_velocity = 0.0f;
+static bool have_prev = false;
+
+void rls_init(RlsEstimator *rls, uint8_t n, float lambda, const float *theta0) {
+    rls->n = (n > RLS_MAX_PARAMS) ? RLS_MAX_PARAMS : n;
+    rls->lambda = lambda;
+    for (uint8_t i = 0; i < RLS_MAX_PARAMS; i++) {
+        rls->theta[i] = (theta0 != NULL && i < rls->n) ? theta0[i] : 0.0f;
+        for (uint8_t j = 0; j < RLS_MAX_PARAMS; j++) {
+            rls->P[i][j] = (i == j) ? RLS_P0 : 0.0f;
+        }
+    }
+}
+
+float rls_update(RlsEstimator *rls, const float *phi, float y) {
+    uint8_t n = rls->n;
+    float Pphi[RLS_MAX_PARAMS];
+    float error = y;
+
+    // Prediction error and P*phi
+    for (uint8_t i = 0; i < n; i++) {
+        error -= phi[i] * rls->theta[i];
+        Pphi[i] = 0.0f;
+        for (uint8_t j = 0; j < n; j++) Pphi[i] += rls->P[i][j] * phi[j];
+    }
+
+    // Gain k = P*phi / (lambda + phi'*P*phi); denominator >= lambda > 0
+    float denom = rls->lambda;
+    for (uint8_t i = 0; i < n; i++) denom += phi[i] * Pphi[i];
+    float inv = 1.0f / denom;
+
+    // theta += k*e, P = (P - k*phi'*P) / lambda, kept symmetric
+    float inv_lambda = 1.0f / rls->lambda;
+    for (uint8_t i = 0; i < n; i++) {
+        rls->theta[i] += Pphi[i] * inv * error;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = i; j < n; j++) {
+            float p = (rls->P[i][j] - Pphi[i] * Pphi[j] * inv) * inv_lambda;
+            if (i == j && p > RLS_P_MAX) p = RLS_P_MAX;
+            rls->P[i][j] = p;
+            rls->P[j][i] = p;
+        }
+    }
+    return error;
+}
+
+void online_estm_init(float lambda) {
+    // Seed with the offline results so tracking starts from a good point
+    float elec0[2] = { motor_R, motor_Ke };
+    float mech0[3] = { motor_J, motor_B, motor_Tc };
+
+    rls_init(&rls_elec, 2, lambda, elec0);
+    rls_init(&rls_mech, 3, lambda, mech0);
+    have_prev = false;
+}
+
+void online_estm_update(float voltage, float current, float velocity) {
+    if (!have_prev) {
+        prev_current = current;
+        prev_velocity = velocity;
+        have_prev = true;
+        return;
+    }
+
+    // Models integrated over the last cycle (trapezoid): the voltage is the one held
+    // during the cycle, so derivatives become exact differences and i, w cycle averages
+    float di_dt = (current - prev_current) * (1.0f / ONLINE_ESTM_TS);
+    float dw_dt = (velocity - prev_velocity) * (1.0f / ONLINE_ESTM_TS);
+    float i_avg = 0.5f * (current + prev_current);
+    float w_avg = 0.5f * (velocity + prev_velocity);
+    prev_current = current;
+    prev_velocity = velocity;
+
+    // --- Electrical: V - L*di/dt = R*i + Ke*w (L held at the offline estimate) ---
+    // L/R is about one cycle, so differences of cycle means carry almost no L information:
+    // fitted here it would only absorb noise
+    if (fabsf(i_avg) > ONLINE_ESTM_MIN_CURRENT) {
+        float phi[2] = { i_avg, w_avg };
+        rls_update(&rls_elec, phi, voltage - motor_L * di_dt);
+
+        if (rls_elec.theta[0] > 0.0f) motor_R = rls_elec.theta[0];
+        if (rls_elec.theta[1] > 0.0f) {
+            motor_Ke = rls_elec.theta[1];
+            motor_Kt = motor_Ke; // Assume Kt = Ke (SI units)
+        }
+    }
+
+    // --- Mechanical: Kt*i = J*dw/dt + B*w + Tc*sign(w) ---
+    // Without the Coulomb column, Tc would be absorbed into B as B + Tc/|w|
+    if (motor_Kt > 0.0001f && fabsf(w_avg) > ONLINE_ESTM_MIN_VELOCITY) {
+        float phi[3] = { dw_dt, w_avg, (w_avg > 0.0f) ? 1.0f : -1.0f };
+        rls_update(&rls_mech, phi, motor_Kt * i_avg);
+
+        if (rls_mech.theta[0] > 0.0f) motor_J = rls_mech.theta[0];
+        if (rls_mech.theta[1] >= 0.0f) motor_B = rls_mech.theta[1];
+        if (rls_mech.theta[2] >= 0.0f) motor_Tc = rls_mech.theta[2];
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef INC_MOTOR_PARAMS_RLS_H_
+#define INC_MOTOR_PARAMS_RLS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Online Estimator Configuration ---
+#define RLS_MAX_PARAMS 3          // Largest model (mechanical: J, B, Tc)
+#define RLS_P0 1000.0f            // Initial covariance diagonal (no prior confidence)
+#define RLS_P_MAX 1.0e6f          // Covariance diagonal clamp (windup guard under poor excitation)
+#define ONLINE_ESTM_TS 0.001f     // Update period (s), one control cycle
+#define ONLINE_ESTM_MIN_CURRENT 0.05f // Below this |i| the electrical model is not excited (A)
+#define ONLINE_ESTM_MIN_VELOCITY 0.5f // Below this |w| the mechanical model is not excited (rad/s)
+
+// --- Recursive Least-Squares Estimator ---
+// y = phi' * theta, exponentially weighted with forgetting factor lambda
+typedef struct {
+    uint8_t n;                                  // Number of parameters
+    float lambda;                               // Forgetting factor (0.99..0.9999)
+    float theta[RLS_MAX_PARAMS];                // Parameter estimate
+    float P[RLS_MAX_PARAMS][RLS_MAX_PARAMS];    // Covariance
+} RlsEstimator;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Initializes an RLS estimator.
+ * @param theta0 Initial parameters (may be NULL for zeros).
+ */
+void rls_init(RlsEstimator *rls, uint8_t n, float lambda, const float *theta0);
+
+/**
+ * @brief One RLS update with regressor phi and measurement y.
+ * @note O(n^2) with n <= RLS_MAX_PARAMS: bounded cost, no allocation, no division by the data.
+ * @return Prediction error before the update.
+ */
+float rls_update(RlsEstimator *rls, const float *phi, float y);
+
+/**
+ * @brief Starts online tracking of R, Ke/Kt, J, B and Tc.
+ * @note L stays at its offline estimate: with L/R close to ONLINE_ESTM_TS it is not
+ *       observable from differences of cycle means.
+ * @note Seeds from the current motor_* globals (offline estimates) when they are valid.
+ * @param lambda Forgetting factor; time constant is ONLINE_ESTM_TS / (1 - lambda).
+ */
+void online_estm_init(float lambda);
+
+/**
+ * @brief Feeds one control-cycle sample and refreshes the motor_* globals.
+ * @note Call every ONLINE_ESTM_TS during normal operation.
+ *       Electrical model: V - L*di/dt = R*i + Ke*w  (L fixed)
+ *       Mechanical model: Kt*i = J*dw/dt + B*w + Tc*sign(w)  (Kt = Ke)
+ *       Each model only updates while it is excited, and a global is only
+ *       overwritten with a physically plausible (positive) value.
+ * @param voltage Terminal voltage applied during the cycle that just ended (V).
+ * @param current Motor current (A).
+ * @param velocity Shaft velocity (rad/s).
+ */
+void online_estm_update(float voltage, float current, float velocity);
+
+#endif /* INC_MOTOR_PARAMS_RLS_H_ */
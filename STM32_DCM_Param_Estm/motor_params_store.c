@@ -0,0 +1,281 @@
+#include "motor_params_store.h"
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "motor_params_rl.h"   // motor_R, motor_L, V_SUPPLY
+#include "motor_params_jb.h"   // motor_Ke, motor_Kt, motor_J, motor_B, motor_Tc
+#include "motor_adc.h"         // ADC_RESOLUTION, V_REF, SHUNT_RESISTOR, PWM_FREQ_HZ
+#include "motor_encoder.h"     // ENCODER_CPR
+
+#define RECORD_WORDS (PARAM_RECORD_SIZE / 4U)
+#define ERASED_WORD 0xFFFFFFFFUL
+
+// --- Store State ---
+static bool scanned = false;     // Scan done since boot (or since the last erase)
+static uint32_t next_slot = 0;   // First erased slot, PARAM_STORE_SLOTS when full
+static uint32_t last_sequence = 0;
+static bool have_last = false;   // last_record is the newest CRC-valid record
+static ParamRecord last_record;
+static uint32_t erase_count = 0;
+
+// --- Flash Backend ---
+// Offsets are relative to PARAM_STORE_ADDR and word aligned.
+
+#ifndef HOST_SIM
+
+#include "main.h"
+
+static void flash_read(uint32_t offset, void *dst, uint32_t len) {
+    memcpy(dst, (const void *)(PARAM_STORE_ADDR + offset), len);
+}
+
+static bool flash_program(uint32_t offset, const uint32_t *words, uint32_t n) {
+    bool ok = true;
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < n && ok; i++) {
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, PARAM_STORE_ADDR + offset + 4U * i, words[i]) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+static bool flash_erase(void) {
+    // Stalls code fetch from the same bank for the erase time (1-2 s for 128 KB); the motor
+    // must be idle, which the caller checks (main.c param_store_task)
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Sector = PARAM_STORE_SECTOR,
+        .NbSectors = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+    };
+    uint32_t sector_error = 0;
+    HAL_FLASH_Unlock();
+    bool ok = HAL_FLASHEx_Erase(&erase, &sector_error) == HAL_OK;
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+#else // HOST_SIM
+
+#include <stdio.h>
+
+static FILE *sim_file = NULL;
+static uint32_t sim_fail_after = 0;  // 0 = never
+static uint32_t sim_programmed = 0;
+
+bool param_store_sim_open(const char *path) {
+    param_store_sim_close();
+    sim_file = fopen(path, "r+b");
+    if (sim_file == NULL) {
+        // New device: erased sector
+        sim_file = fopen(path, "w+b");
+        if (sim_file == NULL) return false;
+        uint8_t ff[256];
+        memset(ff, 0xFF, sizeof(ff));
+        for (uint32_t i = 0; i < PARAM_STORE_SIZE; i += sizeof(ff)) fwrite(ff, 1, sizeof(ff), sim_file);
+        fflush(sim_file);
+    }
+    scanned = false; // Behaves like a reboot
+    sim_programmed = 0;
+    return true;
+}
+
+void param_store_sim_close(void) {
+    if (sim_file != NULL) fclose(sim_file);
+    sim_file = NULL;
+}
+
+void param_store_sim_fail_after(uint32_t words) {
+    sim_fail_after = words;
+    sim_programmed = 0;
+}
+
+static void flash_read(uint32_t offset, void *dst, uint32_t len) {
+    memset(dst, 0xFF, len);
+    if (sim_file == NULL) return;
+    fseek(sim_file, (long)offset, SEEK_SET);
+    if (fread(dst, 1, len, sim_file) != len) memset(dst, 0xFF, len);
+}
+
+static bool flash_program(uint32_t offset, const uint32_t *words, uint32_t n) {
+    if (sim_file == NULL) return false;
+    for (uint32_t i = 0; i < n; i++) {
+        if (sim_fail_after != 0 && sim_programmed >= sim_fail_after) return false; // "Reset"
+        uint32_t word;
+        flash_read(offset + 4U * i, &word, 4U);
+        word &= words[i]; // NOR programming can only clear bits
+        fseek(sim_file, (long)(offset + 4U * i), SEEK_SET);
+        fwrite(&word, 1, 4U, sim_file);
+        sim_programmed++;
+    }
+    fflush(sim_file);
+    return true;
+}
+
+static bool flash_erase(void) {
+    uint8_t ff[256];
+    if (sim_file == NULL) return false;
+    memset(ff, 0xFF, sizeof(ff));
+    fseek(sim_file, 0, SEEK_SET);
+    for (uint32_t i = 0; i < PARAM_STORE_SIZE; i += sizeof(ff)) fwrite(ff, 1, sizeof(ff), sim_file);
+    fflush(sim_file);
+    return true;
+}
+
+#endif // HOST_SIM
+
+// --- Record Helpers ---
+
+static uint32_t crc32(const uint8_t *data, uint32_t len) {
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+static uint32_t record_crc(const ParamRecord *rec) {
+    return crc32((const uint8_t *)rec, (uint32_t)offsetof(ParamRecord, crc));
+}
+
+// Parameters measured with other scaling (supply, shunt, encoder, ...) are not reused
+static uint32_t config_id(void) {
+    struct {
+        float v_supply, v_ref, shunt;
+        uint32_t adc_resolution, adc_offset, pwm_freq_hz, encoder_cpr;
+    } cfg = { V_SUPPLY, V_REF, SHUNT_RESISTOR, ADC_RESOLUTION, ADC_CURRENT_OFFSET, PWM_FREQ_HZ, ENCODER_CPR };
+    return crc32((const uint8_t *)&cfg, sizeof(cfg));
+}
+
+static void record_from_globals(ParamRecord *rec, uint16_t flags) {
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = PARAM_RECORD_MAGIC;
+    rec->version = PARAM_RECORD_VERSION;
+    rec->flags = flags;
+    rec->sequence = last_sequence + 1U;
+    rec->config_id = config_id();
+    rec->R = motor_R;
+    rec->L = motor_L;
+    rec->Ke = motor_Ke;
+    rec->Kt = motor_Kt;
+    rec->J = motor_J;
+    rec->B = motor_B;
+    rec->Tc = motor_Tc;
+    if (friction_map_valid()) rec->friction = motor_friction;
+    rec->crc = record_crc(rec);
+}
+
+// Whole slot checked, not just the magic: records of another layout version may straddle it
+static bool slot_erased(const ParamRecord *rec) {
+    const uint32_t *words = (const uint32_t *)rec;
+    for (uint32_t i = 0; i < RECORD_WORDS; i++) {
+        if (words[i] != ERASED_WORD) return false;
+    }
+    return true;
+}
+
+// Finds the newest valid record and the first free slot
+static void scan(void) {
+    ParamRecord rec;
+    next_slot = PARAM_STORE_SLOTS;
+    have_last = false;
+    last_sequence = 0;
+
+    for (uint32_t slot = 0; slot < PARAM_STORE_SLOTS; slot++) {
+        flash_read(slot * PARAM_RECORD_SIZE, &rec, PARAM_RECORD_SIZE);
+        if (slot_erased(&rec)) {
+            next_slot = slot; // Slots are filled in order: the rest is erased too
+            break;
+        }
+        if (rec.magic != PARAM_RECORD_MAGIC || rec.crc != record_crc(&rec)) continue; // Torn write
+
+        // Sequence only grows within a sector, but compare anyway in case of a stray slot
+        if (!have_last || (int32_t)(rec.sequence - last_sequence) > 0) {
+            last_record = rec;
+            last_sequence = rec.sequence;
+            have_last = true;
+        }
+    }
+    scanned = true;
+}
+
+static bool append(const ParamRecord *rec) {
+    if (!scanned) scan();
+
+    if (next_slot >= PARAM_STORE_SLOTS) {
+        // A reset between erase and program leaves no record: the next boot re-estimates
+        if (!flash_erase()) return false;
+        erase_count++;
+        next_slot = 0;
+    }
+
+    uint32_t offset = next_slot * PARAM_RECORD_SIZE;
+    uint32_t words[RECORD_WORDS];
+    memcpy(words, rec, PARAM_RECORD_SIZE);
+    next_slot++; // Consumed even if programming fails halfway
+    if (!flash_program(offset, words, RECORD_WORDS)) return false;
+
+    // Read back: a slot that was not fully erased (or a failed program) shows up here
+    ParamRecord check;
+    flash_read(offset, &check, PARAM_RECORD_SIZE);
+    if (memcmp(&check, rec, PARAM_RECORD_SIZE) != 0) return false;
+
+    last_record = *rec;
+    last_sequence = rec->sequence;
+    have_last = true;
+    return true;
+}
+
+// --- Public Functions ---
+
+ParamStoreStatus param_store_load(void) {
+    scan();
+    if (!have_last) return PARAM_STORE_EMPTY;
+    if (last_record.flags & PARAM_FLAG_INVALIDATED) return PARAM_STORE_INVALIDATED;
+    if (last_record.version != PARAM_RECORD_VERSION || last_record.config_id != config_id()) {
+        return PARAM_STORE_STALE;
+    }
+
+    motor_R = last_record.R;
+    motor_L = last_record.L;
+    motor_Ke = last_record.Ke;
+    motor_Kt = last_record.Kt;
+    motor_J = last_record.J;
+    motor_B = last_record.B;
+    motor_Tc = last_record.Tc;
+    if (last_record.friction.w_max > 0.0f) friction_map_load(&last_record.friction);
+    return PARAM_STORE_OK;
+}
+
+bool param_store_save(void) {
+    ParamRecord rec;
+    if (!scanned) scan();
+    record_from_globals(&rec, 0);
+    return append(&rec);
+}
+
+bool param_store_invalidate(void) {
+    ParamRecord rec;
+    if (!scanned) scan();
+    if (have_last && (last_record.flags & PARAM_FLAG_INVALIDATED)) return true; // Already
+    record_from_globals(&rec, PARAM_FLAG_INVALIDATED);
+    return append(&rec);
+}
+
+static bool moved(float now, float stored, float rel_tol) {
+    return fabsf(now - stored) > rel_tol * fabsf(stored);
+}
+
+bool param_store_drifted(float rel_tol) {
+    if (!scanned) scan();
+    if (!have_last || (last_record.flags & PARAM_FLAG_INVALIDATED)) return true;
+    return moved(motor_R, last_record.R, rel_tol) || moved(motor_L, last_record.L, rel_tol) ||
+           moved(motor_Ke, last_record.Ke, rel_tol) || moved(motor_Kt, last_record.Kt, rel_tol) ||
+           moved(motor_J, last_record.J, rel_tol) || moved(motor_B, last_record.B, rel_tol) ||
+           moved(motor_Tc, last_record.Tc, rel_tol);
+}
+
+uint32_t param_store_erase_count(void) {
+    return erase_count;
+}
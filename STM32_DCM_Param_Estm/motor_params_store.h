@@ -0,0 +1,90 @@
+#ifndef INC_MOTOR_PARAMS_STORE_H_
+#define INC_MOTOR_PARAMS_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "motor_params_friction.h" // FrictionModel
+
+// --- Flash Layout ---
+// One sector reserved for parameter records (remove it from the FLASH region in the linker script).
+// Records are appended back to back and the newest valid one wins; the sector is erased only
+// when it is full, so an update costs one erase per PARAM_STORE_SLOTS writes.
+#define PARAM_STORE_ADDR 0x080E0000UL      // STM32F407: sector 11
+#define PARAM_STORE_SIZE 0x20000UL         // 128 KB
+#define PARAM_STORE_SECTOR 11U             // FLASH_SECTOR_11
+#define PARAM_RECORD_MAGIC 0x4D504152UL    // "RAPM"
+#define PARAM_RECORD_VERSION 2U            // Bump when ParamRecord changes
+#define PARAM_RECORD_SIZE sizeof(ParamRecord)
+#define PARAM_STORE_SLOTS (PARAM_STORE_SIZE / PARAM_RECORD_SIZE)
+#define PARAM_STORE_SAVE_INTERVAL_MS 600000U // Online drift is written back at most this often
+#define PARAM_STORE_DRIFT_TOL 0.05f          // Relative change that is worth a write
+
+// --- Parameter Record ---
+// Written word by word in field order: magic first, crc last. A write torn by a reset
+// leaves a used slot with a bad CRC, which the scan skips.
+typedef struct {
+    uint32_t magic;      // PARAM_RECORD_MAGIC
+    uint16_t version;    // PARAM_RECORD_VERSION
+    uint16_t flags;      // PARAM_FLAG_*
+    uint32_t sequence;   // Increments with every write
+    uint32_t config_id;  // Hardware scaling the parameters were measured with
+    float R, L, Ke, Kt, J, B, Tc;
+    FrictionModel friction; // w_max = 0 when no map was measured
+    uint32_t crc;        // CRC-32 of all preceding bytes
+} ParamRecord;
+
+#define PARAM_FLAG_INVALIDATED 0x0001U // Tombstone: re-estimate on next boot
+
+typedef enum {
+    PARAM_STORE_OK,           // motor_* loaded
+    PARAM_STORE_EMPTY,        // No valid record (new board or all torn)
+    PARAM_STORE_INVALIDATED,  // param_store_invalidate() was called
+    PARAM_STORE_STALE         // Other record version or hardware configuration
+} ParamStoreStatus;
+
+// --- Public Function Prototypes ---
+
+/**
+ * @brief Finds the newest valid record and loads it into motor_R/L/Ke/Kt/J/B/Tc and the friction map.
+ * @note Globals are only written when the result is PARAM_STORE_OK.
+ */
+ParamStoreStatus param_store_load(void);
+
+/**
+ * @brief Appends a record with the current motor_* values and friction map.
+ * @note Erases the sector first when no free slot is left (blocks for the erase). Call
+ *       only with the motor idle: programming and erasing stall code fetch from flash.
+ * @return false if programming or the read-back check failed.
+ */
+bool param_store_save(void);
+
+/**
+ * @brief Appends a tombstone so the next boot re-estimates.
+ */
+bool param_store_invalidate(void);
+
+/**
+ * @brief True if any motor_* value moved more than rel_tol from the stored record.
+ */
+bool param_store_drifted(float rel_tol);
+
+/**
+ * @brief Sector erases since boot (wear diagnostics).
+ */
+uint32_t param_store_erase_count(void);
+
+#ifdef HOST_SIM
+/**
+ * @brief Backs the flash sector with a file (created erased if missing).
+ * @note Programming only clears bits and erase sets them, like NOR flash.
+ */
+bool param_store_sim_open(const char *path);
+void param_store_sim_close(void);
+
+/**
+ * @brief Simulates a reset after the given number of programmed words (0 disables).
+ */
+void param_store_sim_fail_after(uint32_t words);
+#endif
+
+#endif /* INC_MOTOR_PARAMS_STORE_H_ */